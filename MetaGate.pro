@@ -21,7 +21,13 @@ SOURCES += src/main.cpp src/mainwindow.cpp \
     src/uploader.cpp \
     src/EthWallet.cpp \
     src/ethtx/scrypt/crypto_scrypt-nosse.cpp \
+    src/ethtx/scrypt/crypto_scrypt-sse.cpp \
+    src/ethtx/scrypt/crypto_scrypt-avx2.cpp \
+    src/ethtx/scrypt/crypto_scrypt.cpp \
+    src/ethtx/scrypt/crypto_scrypt_arena.cpp \
+    src/ethtx/scrypt/cpufeatures.cpp \
     src/ethtx/scrypt/sha256.cpp \
+    src/ethtx/scrypt/sha256-x86.cpp \
     src/ethtx/cert.cpp \
     src/ethtx/rlp.cpp \
     src/ethtx/ethtx.cpp \
@@ -32,6 +38,7 @@ SOURCES += src/main.cpp src/mainwindow.cpp \
     src/btctx/btctx.cpp \
     src/btctx/wif.cpp \
     src/BtcWallet.cpp \
+    src/KdfProfiles.cpp \
     src/VersionWrapper.cpp \
     src/StopApplication.cpp \
     src/tests.cpp \
@@ -39,6 +46,10 @@ SOURCES += src/main.cpp src/mainwindow.cpp \
     src/openssl_wrapper/openssl_wrapper.cpp \
     src/utils.cpp \
     src/ethtx/utils2.cpp \
+    src/ethtx/keccak.cpp \
+    src/ethtx/hex.cpp \
+    src/ethtx/abi.cpp \
+    src/ethtx/secp256k1ctx.cpp \
     src/tests2.cpp \
     src/NsLookup.cpp \
     src/dns/datatransformer.cpp \
@@ -46,6 +57,11 @@ SOURCES += src/main.cpp src/mainwindow.cpp \
     src/dns/resourcerecord.cpp \
     src/WebSocketClient.cpp \
     src/JavascriptWrapper.cpp \
+    src/CryptoExecutor.cpp \
+    src/LockedBuffer.cpp \
+    src/WalletsCache.cpp \
+    src/WalletsIndex.cpp \
+    src/BridgeMetrics.cpp \
     src/PagesMappings.cpp
 
 unix: SOURCES += src/machine_uid_unix.cpp
@@ -61,7 +77,10 @@ HEADERS += src/mainwindow.h \
     src/EthWallet.h \
     src/ethtx/scrypt/libscrypt.h \
     src/ethtx/scrypt/sha256.h \
+    src/ethtx/scrypt/sha256_blocks.h \
     src/ethtx/scrypt/sysendian.h \
+    src/ethtx/scrypt/crypto_scrypt_smix.h \
+    src/ethtx/scrypt/cpufeatures.h \
     src/ethtx/cert.h \
     src/ethtx/const.h \
     src/ethtx/rlp.h \
@@ -76,6 +95,7 @@ HEADERS += src/mainwindow.h \
     src/platform.h \
     src/VersionWrapper.h \
     src/BtcWallet.h \
+    src/KdfProfiles.h \
     src/StopApplication.h \
     src/tests.h \
     src/Log.h \
@@ -83,6 +103,10 @@ HEADERS += src/mainwindow.h \
     src/openssl_wrapper/openssl_wrapper.h \
     src/utils.h \
     src/ethtx/utils2.h \
+    src/ethtx/keccak.h \
+    src/ethtx/hex.h \
+    src/ethtx/abi.h \
+    src/ethtx/secp256k1ctx.h \
     src/tests2.h \
     src/NsLookup.h \
     src/dns/datatransformer.h \
@@ -90,6 +114,11 @@ HEADERS += src/mainwindow.h \
     src/dns/resourcerecord.h \
     src/WebSocketClient.h \
     src/JavascriptWrapper.h \
+    src/CryptoExecutor.h \
+    src/LockedBuffer.h \
+    src/WalletsCache.h \
+    src/WalletsIndex.h \
+    src/BridgeMetrics.h \
     src/algorithms.h \
     src/PagesMappings.h \
     src/SlotWrapper.h
@@ -0,0 +1,74 @@
+#include "BridgeMetrics.h"
+
+#include <algorithm>
+
+#include <QJsonObject>
+#include <QJsonDocument>
+
+size_t BridgeMetrics::getBucket(uint64_t us) {
+    if (us < 4) {
+        return us;
+    }
+    size_t log2 = 0;
+    while ((us >> log2) >= 8) {
+        log2++;
+    }
+    // us = (4 + sub) * 2^log2 + остаток
+    const size_t sub = (us >> log2) - 4;
+    return std::min((log2 + 1) * 4 + sub, COUNT_BUCKETS - 1);
+}
+
+uint64_t BridgeMetrics::getBucketUpperBound(size_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    const size_t log2 = bucket / 4 - 1;
+    const size_t sub = bucket % 4;
+    return ((4 + sub + 1) << log2) - 1;
+}
+
+uint64_t BridgeMetrics::Histogram::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max(uint64_t(1), uint64_t(q * count + 0.5));
+    uint64_t sum = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        sum += buckets[i];
+        if (sum >= rank) {
+            return std::min(getBucketUpperBound(i), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+void BridgeMetrics::add(const std::string &method, microseconds duration, bool isError) {
+    const uint64_t us = std::max(duration.count(), decltype(duration.count())(0));
+    std::lock_guard<std::mutex> lock(mut);
+    Histogram &histogram = methods[method];
+    histogram.buckets[getBucket(us)]++;
+    histogram.count++;
+    if (isError) {
+        histogram.errors++;
+    }
+    histogram.sumUs += us;
+    histogram.maxUs = std::max(histogram.maxUs, us);
+}
+
+QString BridgeMetrics::getJson() const {
+    QJsonObject result;
+    std::lock_guard<std::mutex> lock(mut);
+    for (const auto &pair: methods) {
+        const Histogram &histogram = pair.second;
+        QJsonObject method;
+        method.insert("count", double(histogram.count));
+        method.insert("errors", double(histogram.errors));
+        method.insert("avg_us", double(histogram.count == 0 ? 0 : histogram.sumUs / histogram.count));
+        method.insert("p50_us", double(histogram.percentile(0.5)));
+        method.insert("p95_us", double(histogram.percentile(0.95)));
+        method.insert("p99_us", double(histogram.percentile(0.99)));
+        method.insert("max_us", double(histogram.maxUs));
+        result.insert(QString::fromStdString(pair.first), method);
+    }
+    return QJsonDocument(result).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,56 @@
+#ifndef BRIDGEMETRICS_H
+#define BRIDGEMETRICS_H
+
+#include <string>
+#include <map>
+#include <array>
+#include <mutex>
+
+#include <QString>
+
+#include "duration.h"
+
+/*
+   Счетчики вызовов, ошибок и гистограммы времени выполнения методов js моста.
+   Гистограмма логарифмическая: 4 корзины на каждую степень двойки микросекунд, погрешность перцентилей до 25%
+   */
+class BridgeMetrics {
+public:
+
+    void add(const std::string &method, microseconds duration, bool isError);
+
+    QString getJson() const;
+
+private:
+
+    static const size_t COUNT_BUCKETS = 64 * 4;
+
+    struct Histogram {
+        std::array<uint64_t, COUNT_BUCKETS> buckets{};
+
+        uint64_t count = 0;
+
+        uint64_t errors = 0;
+
+        uint64_t sumUs = 0;
+
+        uint64_t maxUs = 0;
+
+        uint64_t percentile(double q) const;
+    };
+
+private:
+
+    static size_t getBucket(uint64_t us);
+
+    static uint64_t getBucketUpperBound(size_t bucket);
+
+private:
+
+    std::map<std::string, Histogram> methods;
+
+    mutable std::mutex mut;
+
+};
+
+#endif // BRIDGEMETRICS_H
@@ -12,10 +12,28 @@
 #include <algorithm>
 #include <iostream>
 
+#include <cryptopp/misc.h>
+
 #include <QDir>
 
 const static std::string WIF_AND_ADDRESS_DELIMITER = " ";
 
+// Необязательное третье поле файла - параметры scrypt, если они отличаются от BIP38
+const static std::string KDF_PARAMS_PREFIX = "scrypt:";
+
+struct WalletFile {
+    std::string wif;
+    std::string address;
+    ScryptParams kdfParams = BIP38_SCRYPT_PARAMS;
+
+    // Без пароля в файле лежит открытый wif
+    ~WalletFile() {
+        if (!wif.empty()) {
+            CryptoPP::SecureWipeBuffer((byte*)&wif[0], wif.size());
+        }
+    }
+};
+
 static QString convertAddressToFileName(const std::string &address) {
     return QString::fromStdString(address.substr(0, address.size() - 3) + "---").toLower();
 }
@@ -28,55 +46,89 @@ QString BtcWallet::getFullPath(const QString &folder, const std::string &address
     return pathToFile;
 }
 
-static std::pair<std::string, std::string> getWifAndAddress(const QString &folder, const std::string &addr, bool isNoEncrypted) {
+static std::string kdfParamsToString(const ScryptParams &kdfParams) {
+    return KDF_PARAMS_PREFIX + std::to_string(kdfParams.n) + ":" + std::to_string(kdfParams.r) + ":" + std::to_string(kdfParams.p);
+}
+
+static ScryptParams parseKdfParams(const std::string &str) {
+    CHECK(str.compare(0, KDF_PARAMS_PREFIX.size(), KDF_PARAMS_PREFIX) == 0, "Incorrect kdf params " + str);
+    std::vector<uint64_t> values;
+    size_t pos = KDF_PARAMS_PREFIX.size();
+    while (pos <= str.size()) {
+        size_t end = str.find(':', pos);
+        if (end == str.npos) {
+            end = str.size();
+        }
+        const std::string value = str.substr(pos, end - pos);
+        CHECK(!value.empty() && value.find_first_not_of("0123456789") == value.npos, "Incorrect kdf params " + str);
+        values.emplace_back(std::stoull(value));
+        pos = end + 1;
+    }
+    CHECK(values.size() == 3, "Incorrect kdf params " + str);
+    return ScryptParams{values[0], (uint32_t)values[1], (uint32_t)values[2]};
+}
+
+static WalletFile getWifAndAddress(const QString &folder, const std::string &addr, bool isNoEncrypted) {
     const QString pathToFile = BtcWallet::getFullPath(folder, addr);
     const std::string wifAndAddress = readFile(pathToFile);
     const size_t foundDelimiter = wifAndAddress.find(WIF_AND_ADDRESS_DELIMITER);
-    std::string wif;
-    std::string address;
+    WalletFile result;
     if (foundDelimiter == wifAndAddress.npos) {
-        wif = wifAndAddress;
+        result.wif = wifAndAddress;
         if (isNoEncrypted) {
             bool tmp;
-            address = ::getAddress(wif, tmp, false);
+            result.address = ::getAddress(result.wif, tmp, false);
         }
     } else {
-        wif = wifAndAddress.substr(0, foundDelimiter);
-        address = wifAndAddress.substr(foundDelimiter + 1);
+        result.wif = wifAndAddress.substr(0, foundDelimiter);
+        const size_t foundDelimiter2 = wifAndAddress.find(WIF_AND_ADDRESS_DELIMITER, foundDelimiter + 1);
+        if (foundDelimiter2 == wifAndAddress.npos) {
+            result.address = wifAndAddress.substr(foundDelimiter + 1);
+        } else {
+            result.address = wifAndAddress.substr(foundDelimiter + 1, foundDelimiter2 - foundDelimiter - 1);
+            result.kdfParams = parseKdfParams(wifAndAddress.substr(foundDelimiter2 + 1));
+        }
     }
 
-    return std::make_pair(wif, address);
+    return result;
 }
 
-std::pair<std::string, std::string> BtcWallet::genPrivateKey(const QString &folder, const QString &password) {
+std::pair<std::string, std::string> BtcWallet::genPrivateKey(const QString &folder, const QString &password, const std::string &kdfProfile) {
+    const ScryptParams kdfParams = getBtcKdfProfile(kdfProfile);
     const bool isCompressed = true;
     const bool isTestnet = false;
     std::string wif = CreateWIF(isTestnet, isCompressed);
     bool tmp;
     const std::string addressBase58 = ::getAddress(wif, tmp, isTestnet);
     CHECK(isCompressed == tmp, "ups");
+    std::string fileContent;
     if (!password.isNull() && !password.isEmpty()) {
-        wif = encryptWif(wif, password.normalized(QString::NormalizationForm_C).toStdString());
+        wif = encryptWif(wif, password.normalized(QString::NormalizationForm_C).toStdString(), kdfParams);
         CHECK(wif.substr(0, 2) == "6P", "Incorrect encrypted wif " + wif);
+        fileContent = wif + WIF_AND_ADDRESS_DELIMITER + addressBase58;
+        if (kdfParams != BIP38_SCRYPT_PARAMS) {
+            fileContent += WIF_AND_ADDRESS_DELIMITER + kdfParamsToString(kdfParams);
+        }
     } else {
         CHECK(wif.substr(0, 2) != "6P", "Incorrect encrypted wif " + wif);
+        fileContent = wif + WIF_AND_ADDRESS_DELIMITER + addressBase58;
     }
 
     const QString fileName = QDir(folder).filePath(convertAddressToFileName(addressBase58));
-    writeToFile(fileName, wif + WIF_AND_ADDRESS_DELIMITER + addressBase58, true);
+    writeToFile(fileName, fileContent, true);
 
     return std::make_pair(addressBase58, wif);
 }
 
 BtcWallet::BtcWallet(const QString &folder, const std::string &address_, const QString &password) {
-    const auto pair = getWifAndAddress(folder, address_, false);
-    const std::string wifEncrypted = pair.first;
-    address = pair.second;
+    const WalletFile walletFile = getWifAndAddress(folder, address_, false);
+    const std::string &wifEncrypted = walletFile.wif;
+    address = walletFile.address;
 
     wif = wifEncrypted;
     if (!password.isNull() && !password.isEmpty()) {
         if (wifEncrypted.substr(0, 2) == "6P") {
-            wif = decryptWif(wifEncrypted, password.normalized(QString::NormalizationForm_C).toStdString());
+            wif = decryptWif(wifEncrypted, password.normalized(QString::NormalizationForm_C).toStdString(), walletFile.kdfParams);
         }
     } else {
         CHECK(wifEncrypted.substr(0, 2) != "6P", "Incorrect encrypted wif " + wifEncrypted);
@@ -89,15 +141,31 @@ BtcWallet::BtcWallet(const QString &folder, const std::string &address_, const Q
 }
 
 BtcWallet::BtcWallet(const std::string &decryptedWif)
-    : wif(decryptedWif)
+    : BtcWallet(decryptedWif.data(), decryptedWif.size())
+{}
+
+BtcWallet::BtcWallet(const char *decryptedWif, size_t size)
+    : wif(decryptedWif, size)
 {
-    CHECK(decryptedWif.substr(0, 2) != "6P", "Incorrect encrypted wif " + decryptedWif);
+    CHECK(wif.substr(0, 2) != "6P", "Incorrect encrypted wif " + wif);
+    bool tmp;
+    address = ::getAddress(wif, tmp, false);
+}
+
+BtcWallet::~BtcWallet() {
+    if (!wif.empty()) {
+        CryptoPP::SecureWipeBuffer((byte*)&wif[0], wif.size());
+    }
 }
 
 const std::string& BtcWallet::getAddress() const {
     return address;
 }
 
+const std::string& BtcWallet::getWif() const {
+    return wif;
+}
+
 std::string BtcWallet::genTransaction(const std::vector<BtcInput> &inputs, uint64_t transferAmount, uint64_t fee, const std::string &receiveAddress, bool isTestnet) {
     checkAddressBase56(receiveAddress);
 
@@ -259,10 +327,18 @@ std::vector<std::pair<QString, QString>> BtcWallet::getAllWalletsInFolder(const
     const QDir dir(folder);
     const QStringList allFiles = dir.entryList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
     for (const QString &file: allFiles) {
-        const std::string address = getWifAndAddress(folder, file.toStdString(), true).second;
-        CHECK(!address.empty(), "empty result");
-        result.emplace_back(QString::fromStdString(address), getFullPath(folder, address));
+        std::pair<QString, QString> wallet;
+        if (getWalletFromFile(folder, file, wallet)) {
+            result.emplace_back(wallet);
+        }
     }
 
     return result;
 }
+
+bool BtcWallet::getWalletFromFile(const QString &folder, const QString &fileName, std::pair<QString, QString> &wallet) {
+    const std::string address = getWifAndAddress(folder, fileName.toStdString(), true).address;
+    CHECK(!address.empty(), "empty result");
+    wallet = std::make_pair(QString::fromStdString(address), getFullPath(folder, address));
+    return true;
+}
@@ -6,6 +6,8 @@
 
 #include <QString>
 
+#include "KdfProfiles.h"
+
 struct BtcInput {
     std::string spendtxid;
     uint32_t spendoutnum;
@@ -29,12 +31,20 @@ public:
 
     static QString getFullPath(const QString &folder, const std::string &address);
 
-    static std::pair<std::string, std::string> genPrivateKey(const QString &folder, const QString &password);
+    /*
+       Ключ шифруется по BIP38 со scrypt из профиля kdfProfile. Параметры не из BIP38 записываются в файл кошелька
+       */
+    static std::pair<std::string, std::string> genPrivateKey(const QString &folder, const QString &password, const std::string &kdfProfile = KDF_PROFILE_STANDARD);
 
     BtcWallet(const QString &folder, const std::string &address, const QString &password);
 
     BtcWallet(const std::string &decryptedWif);
 
+    BtcWallet(const char *decryptedWif, size_t size);
+
+    // Затирает wif
+    ~BtcWallet();
+
     std::string genTransaction(const std::vector<BtcInput> &inputs, uint64_t transferAmount, uint64_t fee, const std::string &receiveAddress, bool isTestnet);
 
     std::string buildTransaction(
@@ -47,8 +57,12 @@ public:
 
     static std::vector<std::pair<QString, QString>> getAllWalletsInFolder(const QString &folder);
 
+    static bool getWalletFromFile(const QString &folder, const QString &fileName, std::pair<QString, QString> &wallet);
+
     const std::string& getAddress() const;
 
+    const std::string& getWif() const;
+
 private:
 
     std::string encode(
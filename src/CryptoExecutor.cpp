@@ -0,0 +1,182 @@
+#include "CryptoExecutor.h"
+
+#include <algorithm>
+
+#include "ethtx/scrypt/libscrypt.h"
+
+#include "BridgeMetrics.h"
+
+#include "check.h"
+#include "Log.h"
+
+// Каждый scrypt с N=262144 занимает 256 Мб, поэтому количество потоков ограничено
+const static size_t MAX_COUNT_THREADS = 4;
+const static size_t MIN_COUNT_THREADS = 2;
+
+const static milliseconds PROGRESS_PERIOD = 250ms;
+
+struct CurrentTask {
+    const std::string *requestId = nullptr;
+    const std::atomic<bool> *isCancelled = nullptr;
+    time_point lastProgress;
+};
+
+static thread_local CurrentTask currentTask;
+
+CryptoExecutor::CryptoExecutor(size_t countThreads) {
+    if (countThreads == 0) {
+        countThreads = std::min(size_t(std::thread::hardware_concurrency()), MAX_COUNT_THREADS);
+    }
+    // Один поток всегда оставлен для интерактивных задач
+    countThreads = std::max(countThreads, MIN_COUNT_THREADS);
+    maxRunningNotInteractive = countThreads - 1;
+    LOG << "Crypto executor threads " << countThreads;
+    for (size_t i = 0; i < countThreads; i++) {
+        threads.emplace_back(&CryptoExecutor::work, this);
+    }
+}
+
+CryptoExecutor::~CryptoExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        isStopped = true;
+        for (std::deque<TaskInfo> &queue: tasks) {
+            queue.clear();
+        }
+        for (auto &pair: activeRequests) {
+            *pair.second = true;
+        }
+    }
+    cond.notify_all();
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+}
+
+void CryptoExecutor::setProgress(const Progress &progressCallback) {
+    std::lock_guard<std::mutex> lock(mut);
+    progress = progressCallback;
+}
+
+void CryptoExecutor::setMetrics(BridgeMetrics *bridgeMetrics) {
+    std::lock_guard<std::mutex> lock(mut);
+    metrics = bridgeMetrics;
+}
+
+void CryptoExecutor::post(Priority priority, const Task &task) {
+    post("", priority, task);
+}
+
+void CryptoExecutor::post(const std::string &requestId, Priority priority, const Task &task) {
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        CHECK(!isStopped, "Crypto executor stopped");
+        const CancelFlag isCancelled = std::make_shared<std::atomic<bool>>(false);
+        if (!requestId.empty()) {
+            activeRequests.emplace(requestId, isCancelled);
+        }
+        tasks[size_t(priority)].push_back(TaskInfo{requestId, priority, task, isCancelled, ::now()});
+    }
+    cond.notify_all();
+}
+
+bool CryptoExecutor::isTaskReady() const {
+    if (!tasks[size_t(Priority::INTERACTIVE)].empty()) {
+        return true;
+    }
+    if (countRunningNotInteractive >= maxRunningNotInteractive) {
+        return false;
+    }
+    return !tasks[size_t(Priority::KEY_GENERATION)].empty();
+}
+
+void CryptoExecutor::cancel(const std::string &requestId) {
+    std::lock_guard<std::mutex> lock(mut);
+    const auto range = activeRequests.equal_range(requestId);
+    for (auto iter = range.first; iter != range.second; iter++) {
+        *iter->second = true;
+    }
+}
+
+bool CryptoExecutor::isCancelled() {
+    return currentTask.isCancelled != nullptr && *currentTask.isCancelled;
+}
+
+int CryptoExecutor::onScryptProgress(void *arg, uint64_t done, uint64_t total) {
+    if (isCancelled()) {
+        return 1;
+    }
+    CryptoExecutor *executor = static_cast<CryptoExecutor*>(arg);
+    const time_point currTime = ::now();
+    if (executor->progress && !currentTask.requestId->empty() && (currTime - currentTask.lastProgress >= PROGRESS_PERIOD || done == total)) {
+        currentTask.lastProgress = currTime;
+        executor->progress(*currentTask.requestId, done, total);
+    }
+    return 0;
+}
+
+void CryptoExecutor::work() {
+    while (true) {
+        TaskInfo task;
+        BridgeMetrics *taskMetrics = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            cond.wait(lock, [this]{ return isStopped || isTaskReady(); });
+            if (isStopped) {
+                return;
+            }
+            for (std::deque<TaskInfo> &queue: tasks) {
+                if (!queue.empty()) {
+                    task = std::move(queue.front());
+                    queue.pop_front();
+                    break;
+                }
+            }
+            if (task.priority != Priority::INTERACTIVE) {
+                countRunningNotInteractive++;
+            }
+            taskMetrics = metrics;
+        }
+        if (taskMetrics != nullptr) {
+            taskMetrics->add("cryptoExecutor.queue", std::chrono::duration_cast<microseconds>(::now() - task.timePosted), false);
+        }
+
+        currentTask.requestId = &task.requestId;
+        currentTask.isCancelled = task.isCancelled.get();
+        currentTask.lastProgress = ::now();
+        // Запрос отменили, пока задача стояла в очереди. Callback js знает только сама задача,
+        // поэтому она запускается, но apiVrapper в ней сразу возвращает CANCELLED, не выполняя работу
+        const bool isCancelledInQueue = *task.isCancelled;
+        if (isCancelledInQueue) {
+            LOG << "Task cancelled in queue " << task.requestId;
+        } else {
+            libscrypt_set_thread_progress(&CryptoExecutor::onScryptProgress, this);
+        }
+        try {
+            task.task();
+        } catch (const Exception &e) {
+            LOG << "Error " << e;
+        } catch (const std::exception &e) {
+            LOG << "Error " << e.what();
+        } catch (...) {
+            LOG << "Unknown error";
+        }
+        libscrypt_set_thread_progress(nullptr, nullptr);
+        currentTask = CurrentTask();
+
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            if (task.priority != Priority::INTERACTIVE) {
+                countRunningNotInteractive--;
+            }
+            const auto range = activeRequests.equal_range(task.requestId);
+            for (auto iter = range.first; iter != range.second; iter++) {
+                if (iter->second == task.isCancelled) {
+                    activeRequests.erase(iter);
+                    break;
+                }
+            }
+        }
+        cond.notify_all();
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef CRYPTOEXECUTOR_H
+#define CRYPTOEXECUTOR_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <array>
+#include <map>
+#include <vector>
+#include <string>
+
+#include "duration.h"
+
+class BridgeMetrics;
+
+/*
+   Пул потоков для тяжелых криптографических операций (scrypt, генерация ключей),
+   чтобы они не блокировали gui поток.
+   Задачи с requestId можно отменить через cancel: scrypt внутри задачи прерывается на ближайшей проверке,
+   а прогресс scrypt передается в callback progress. Задача, отмененная в очереди, запускается уже отмененной,
+   чтобы сообщить об ошибке, и должна проверить isCancelled до начала работы.
+   Задачи выбираются по приоритету, а неинтерактивные задачи занимают не больше countThreads - 1 потоков,
+   так что для подписи всегда остается свободный поток.
+   */
+class CryptoExecutor {
+public:
+
+    using Task = std::function<void()>;
+
+    using Progress = std::function<void(const std::string &requestId, uint64_t done, uint64_t total)>;
+
+    enum class Priority {
+        // Подпись и расшифровка, которых ждет пользователь
+        INTERACTIVE = 0,
+        KEY_GENERATION = 1
+    };
+
+public:
+
+    explicit CryptoExecutor(size_t countThreads = 0);
+
+    ~CryptoExecutor();
+
+    void setProgress(const Progress &progressCallback);
+
+    /*
+       Время ожидания задач в очереди пишется в метрику cryptoExecutor.queue
+       */
+    void setMetrics(BridgeMetrics *bridgeMetrics);
+
+    void post(Priority priority, const Task &task);
+
+    void post(const std::string &requestId, Priority priority, const Task &task);
+
+    void cancel(const std::string &requestId);
+
+    /*
+       Отменена ли задача, выполняющаяся в текущем потоке
+       */
+    static bool isCancelled();
+
+private:
+
+    using CancelFlag = std::shared_ptr<std::atomic<bool>>;
+
+    struct TaskInfo {
+        std::string requestId;
+        Priority priority = Priority::INTERACTIVE;
+        Task task;
+        CancelFlag isCancelled;
+        time_point timePosted;
+    };
+
+private:
+
+    void work();
+
+    bool isTaskReady() const;
+
+    static int onScryptProgress(void *arg, uint64_t done, uint64_t total);
+
+private:
+
+    std::vector<std::thread> threads;
+
+    // Очередь для каждого приоритета
+    std::array<std::deque<TaskInfo>, 2> tasks;
+
+    size_t countRunningNotInteractive = 0;
+
+    size_t maxRunningNotInteractive = 0;
+
+    std::multimap<std::string, CancelFlag> activeRequests;
+
+    Progress progress;
+
+    BridgeMetrics *metrics = nullptr;
+
+    std::mutex mut;
+
+    std::condition_variable cond;
+
+    bool isStopped = false;
+
+};
+
+#endif // CRYPTOEXECUTOR_H
@@ -3,11 +3,13 @@
 #include <stdlib.h>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <sstream>
 
-#include <cryptopp/keccak.h>
 #include <cryptopp/eccrypto.h>
 
 #include "ethtx/ethtx.h"
+#include "ethtx/abi.h"
 #include "ethtx/utils2.h"
 #include "ethtx/const.h"
 #include "ethtx/cert.h"
@@ -15,6 +17,7 @@
 
 #include "utils.h"
 #include "check.h"
+#include "algorithms.h"
 
 #include <iostream>
 
@@ -33,8 +36,21 @@ EthWallet::EthWallet(
     const QString pathToFile = getFullPath(folder, address);
     const std::string certcontent = readFile(pathToFile);
     CHECK(!certcontent.empty(), "private file empty");
-    rawprivkey.resize(EC_KEY_LENGTH);
-    CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey privkey = DecodeCert(certcontent.c_str(), password, rawprivkey.data());
+    rawprivkey = std::make_unique<LockedBuffer>(EC_KEY_LENGTH);
+    CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey privkey = DecodeCert(certcontent.c_str(), password, (uint8_t*)rawprivkey->data());
+}
+
+EthWallet::EthWallet(const std::string &rawPrivateKey)
+    : EthWallet(rawPrivateKey.data(), rawPrivateKey.size())
+{}
+
+EthWallet::EthWallet(const char *rawPrivateKey, size_t size) {
+    CHECK(size == EC_KEY_LENGTH, "Incorrect private key size");
+    rawprivkey = std::make_unique<LockedBuffer>(rawPrivateKey, size);
+}
+
+const LockedBuffer& EthWallet::getRawPrivateKey() const {
+    return *rawprivkey;
 }
 
 std::string EthWallet::SignTransaction(
@@ -45,13 +61,57 @@ std::string EthWallet::SignTransaction(
     std::string value,
     std::string data
 ) {
-    const std::string transaction = ::SignTransaction(std::string((char*)rawprivkey.data(), rawprivkey.size()), nonce, gasPrice, gasLimit, to, value, data);
-    return transaction;
+    EthTransaction transaction;
+    transaction.nonce = nonce;
+    transaction.gasPrice = gasPrice;
+    transaction.gasLimit = gasLimit;
+    transaction.to = to;
+    transaction.value = value;
+    transaction.data = data;
+    return SignTransaction(transaction);
+}
+
+std::string EthWallet::SignTransaction(const EthTransaction &transaction) {
+    return ::SignTransaction((const uint8_t*)rawprivkey->data(), transaction);
+}
+
+static uint64_t parseNonce(const std::string &nonce) {
+    CHECK(nonce.compare(0, 2, "0x") == 0, "Incorrect nonce " + nonce);
+    const size_t begin = nonce.find_first_not_of('0', 2);
+    if (begin == nonce.npos) {
+        return 0;
+    }
+    CHECK(nonce.size() - begin <= 16 && nonce.find_first_not_of("0123456789abcdefABCDEF", begin) == nonce.npos, "Incorrect nonce " + nonce);
+    return std::stoull(nonce.substr(begin), nullptr, 16);
+}
+
+std::vector<std::string> EthWallet::SignTransactions(const std::vector<EthTransaction> &transactions) {
+    std::vector<std::pair<uint64_t, size_t>> order;
+    order.reserve(transactions.size());
+    for (size_t i = 0; i < transactions.size(); i++) {
+        order.emplace_back(parseNonce(transactions[i].nonce), i);
+    }
+    std::sort(order.begin(), order.end());
+    // Пропуск nonce застопорит в сети все последующие транзакции
+    for (size_t i = 1; i < order.size(); i++) {
+        CHECK(order[i].first != order[i - 1].first, "Duplicate nonce " + transactions[order[i].second].nonce);
+        CHECK(order[i].first == order[i - 1].first + 1, "Nonce gap before " + transactions[order[i].second].nonce);
+    }
+
+    // У каждого потока свой контекст secp256k1 из пула. Ключ читается прямо из защищенного буфера
+    const uint8_t *privateKey = (const uint8_t*)rawprivkey->data();
+    std::vector<std::string> result(transactions.size());
+    parallelFor(order.size(), [&transactions, &order, privateKey, &result](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            result[i] = ::SignTransaction(privateKey, transactions[order[i].second]);
+        }
+    });
+    return result;
 }
 
-std::string EthWallet::genPrivateKey(const QString &folder, const std::string &password) {
+std::string EthWallet::genPrivateKey(const QString &folder, const std::string &password, const std::string &kdfProfile) {
     CHECK(!password.empty(), "Empty password");
-    const auto pair = CreateNewKey(password);
+    const auto pair = CreateNewKey(password, getEthKdfProfile(kdfProfile));
     const std::string &address = pair.first;
     const std::string &keyValue = pair.second;
 
@@ -67,30 +127,77 @@ std::vector<std::pair<QString, QString>> EthWallet::getAllWalletsInFolder(const
 
     const QDir dir(folder);
     const QStringList allFiles = dir.entryList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
-    for (const QString &file: allFiles) {
-        const std::string fileName = file.toStdString();
-        if (fileName.substr(0, 2) == "0x") {
-            const std::string addressPart = fileName.substr(2);
-            const std::string address = "0x" + MixedCaseEncoding(HexStringToDump(addressPart));
-            result.emplace_back(QString::fromStdString(address), getFullPath(folder, address));
+    std::vector<std::pair<QString, QString>> wallets;
+    getWalletsFromFiles(folder, std::vector<QString>(allFiles.begin(), allFiles.end()), wallets);
+    for (const auto &wallet: wallets) {
+        if (!wallet.first.isEmpty()) {
+            result.emplace_back(wallet);
         }
     }
 
     return result;
 }
 
-std::string EthWallet::makeErc20Data(const std::string &valueHex, const std::string &address) {
-    std::string result = "0xa9059cbb";
+bool EthWallet::getWalletFromFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet) {
+    const std::string fileName = file.toStdString();
+    if (fileName.substr(0, 2) != "0x") {
+        return false;
+    }
+    const std::string addressPart = fileName.substr(2);
+    const std::string address = "0x" + MixedCaseEncoding(HexStringToDump(addressPart));
+    wallet = std::make_pair(QString::fromStdString(address), getFullPath(folder, address));
+    return true;
+}
 
-    CHECK(address.substr(0, 2) == "0x", "Incorrect address " + address);
-    CHECK(address.size() == 42, "Incorrect address " + address);
-    CHECK(valueHex.substr(0, 2) == "0x", "Incorrect address " + valueHex);
+void EthWallet::getWalletsFromFiles(const QString &folder, const std::vector<QString> &fileNames, std::vector<std::pair<QString, QString>> &wallets) {
+    std::vector<size_t> indexes;
+    std::vector<std::string> binaryAddresses;
+    for (size_t i = 0; i < fileNames.size(); i++) {
+        const std::string fileName = fileNames[i].toStdString();
+        if (fileName.substr(0, 2) != "0x") {
+            continue;
+        }
+        indexes.emplace_back(i);
+        binaryAddresses.emplace_back(HexStringToDump(fileName.substr(2)));
+    }
 
-    std::string param1 = address.substr(2);
-    param1.insert(param1.begin(), 64 - param1.size(), '0');
+    const std::vector<std::string> addresses = MixedCaseEncoding(binaryAddresses);
+    wallets.assign(fileNames.size(), std::make_pair(QString(), QString()));
+    for (size_t i = 0; i < indexes.size(); i++) {
+        const std::string address = "0x" + addresses[i];
+        wallets[indexes[i]] = std::make_pair(QString::fromStdString(address), getFullPath(folder, address));
+    }
+}
 
-    std::string param2 = valueHex.substr(2);
-    param2.insert(param2.begin(), 64 - param2.size(), '0');
+std::string EthWallet::makeErc20Data(const std::string &valueHex, const std::string &address) {
+    CHECK(valueHex.substr(0, 2) == "0x", "Incorrect value " + valueHex);
+    return Erc20TransferData(address, valueHex);
+}
 
-    return result + param1 + param2;
+std::vector<EthTransaction> EthWallet::makeErc20Payouts(const EthTransaction &baseTransaction, const std::vector<Erc20Payout> &payouts) {
+    const uint64_t firstNonce = parseNonce(baseTransaction.nonce);
+    CHECK(firstNonce + payouts.size() >= firstNonce, "Nonce overflow");
+    // Опечатка в одном адресе отклоняет всю пачку, пока ничего не подписано
+    std::vector<std::string> addresses;
+    addresses.reserve(payouts.size() + 1);
+    addresses.emplace_back(baseTransaction.to);
+    for (const Erc20Payout &payout: payouts) {
+        addresses.emplace_back(payout.to);
+    }
+    const std::vector<bool> checked = CheckMixedCaseAddresses(addresses);
+    for (size_t i = 0; i < addresses.size(); i++) {
+        CHECK(checked[i], "Incorrect address checksum " + addresses[i]);
+    }
+    std::vector<EthTransaction> result;
+    result.reserve(payouts.size());
+    for (size_t i = 0; i < payouts.size(); i++) {
+        EthTransaction tx = baseTransaction;
+        std::stringstream nonce;
+        nonce << "0x" << std::hex << firstNonce + i;
+        tx.nonce = nonce.str();
+        tx.value = "0x0";
+        tx.data = Erc20TransferData(payouts[i].to, payouts[i].amount);
+        result.emplace_back(tx);
+    }
+    return result;
 }
@@ -3,9 +3,20 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #include <QString>
 
+#include "KdfProfiles.h"
+#include "LockedBuffer.h"
+#include "ethtx/ethtx.h"
+
+struct Erc20Payout {
+    std::string to;
+    // 16ричное с 0x или десятичное
+    std::string amount;
+};
+
 class EthWallet {
 public:
 
@@ -15,6 +26,12 @@ public:
         std::string password
     );
 
+    explicit EthWallet(const std::string &rawPrivateKey);
+
+    EthWallet(const char *rawPrivateKey, size_t size);
+
+    const LockedBuffer& getRawPrivateKey() const;
+
     std::string SignTransaction(
         std::string nonce,
         std::string gasPrice,
@@ -24,17 +41,38 @@ public:
         std::string data
     );
 
+    std::string SignTransaction(const EthTransaction &transaction);
+
+    /*
+       Подписывает транзакции параллельно и возвращает их упорядоченными по nonce. Nonce должны идти подряд без повторов и пропусков
+       */
+    std::vector<std::string> SignTransactions(const std::vector<EthTransaction> &transactions);
+
     static QString getFullPath(const QString &folder, const std::string &address);
 
-    static std::string genPrivateKey(const QString &folder, const std::string &password);
+    static std::string genPrivateKey(const QString &folder, const std::string &password, const std::string &kdfProfile = KDF_PROFILE_STANDARD);
 
     static std::vector<std::pair<QString, QString>> getAllWalletsInFolder(const QString &folder);
 
+    static bool getWalletFromFile(const QString &folder, const QString &fileName, std::pair<QString, QString> &wallet);
+
+    /*
+       То же для нескольких файлов, контрольные суммы адресов считаются пачкой. Не кошельку соответствует пустая пара
+       */
+    static void getWalletsFromFiles(const QString &folder, const std::vector<QString> &fileNames, std::vector<std::pair<QString, QString>> &wallets);
+
     static std::string makeErc20Data(const std::string &valueHex, const std::string &address);
 
+    /*
+       Транзакции transfer(to, amount) на контракт baseTransaction.to. Комиссии, тип и chainId берутся из baseTransaction,
+       nonce назначаются подряд начиная с baseTransaction.nonce. Адреса контракта и получателей проверяются по EIP-55
+       */
+    static std::vector<EthTransaction> makeErc20Payouts(const EthTransaction &baseTransaction, const std::vector<Erc20Payout> &payouts);
+
 private:
 
-    std::vector<uint8_t> rawprivkey;
+    // Ключ живет только в защищенной памяти, в std::string не копируется
+    std::unique_ptr<LockedBuffer> rawprivkey;
 
 };
 
@@ -13,10 +13,12 @@
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QTimer>
 
 #include "Wallet.h"
 #include "EthWallet.h"
 #include "BtcWallet.h"
+#include "KdfProfiles.h"
 
 #include "NsLookup.h"
 
@@ -28,6 +30,10 @@
 #include "utils.h"
 #include "TypedException.h"
 
+#include "ethtx/scrypt/libscrypt.h"
+
+#include <cryptopp/misc.h>
+
 #include "machine_uid.h"
 
 const static QString WALLET_PREV_PATH = ".metahash_wallets/";
@@ -38,6 +44,12 @@ const static QString WALLET_PATH_MTH = "mhc/";
 const static QString WALLET_PATH_TMH_OLD = "mth/";
 const static QString WALLET_PATH_TMH = "tmh/";
 
+const static seconds WALLET_UNLOCK_DEFAULT_TIME = 5min;
+const static seconds RSA_KEY_CACHE_TIME = 1min;
+const static seconds WALLET_UNLOCK_MAX_TIME = 1h;
+
+const static seconds METRICS_FILE_PERIOD = 1min;
+
 JavascriptWrapper::JavascriptWrapper(NsLookup &nsLookup, QObject */*parent*/)
     : nsLookup(nsLookup)
 {
@@ -47,6 +59,17 @@ JavascriptWrapper::JavascriptWrapper(NsLookup &nsLookup, QObject */*parent*/)
     LOG << "Wallets default path " << walletPath;
 
     setPaths(walletDefaultPath, "");
+
+    cryptoExecutor.setProgress([this](const std::string &requestId, uint64_t done, uint64_t total) {
+        runJsFunc("requestProgressJs", QString::fromStdString(requestId), {double(done), double(total)}, TypedException(TypeErrors::NOT_ERROR, ""));
+    });
+
+    cryptoExecutor.setMetrics(&bridgeMetrics);
+
+    QTimer *walletsCacheTimer = new QTimer(this);
+    CHECK(connect(walletsCacheTimer, SIGNAL(timeout()), this, SLOT(onWalletsCacheTimer())), "not connect timeout");
+    walletsCacheTimer->setInterval(milliseconds(1s).count());
+    walletsCacheTimer->start();
 }
 
 void JavascriptWrapper::setWidget(QWidget *widget) {
@@ -54,7 +77,7 @@ void JavascriptWrapper::setWidget(QWidget *widget) {
 }
 
 template<class Function>
-static TypedException apiVrapper(const Function &func) {
+static TypedException apiVrapperImpl(const Function &func) {
     try {
         func();
         return TypedException(TypeErrors::NOT_ERROR, "");
@@ -73,6 +96,49 @@ static TypedException apiVrapper(const Function &func) {
     }
 }
 
+template<class Function>
+TypedException JavascriptWrapper::apiVrapper(const std::string &method, const Function &func) {
+    // Задача executor, отмененная до начала, сразу отдает ошибку в свой callback
+    if (CryptoExecutor::isCancelled()) {
+        return TypedException(TypeErrors::CANCELLED, "Request cancelled");
+    }
+    const time_point timeBegin = ::now();
+    TypedException exception = apiVrapperImpl(func);
+    if (exception.numError != TypeErrors::NOT_ERROR && CryptoExecutor::isCancelled()) {
+        exception = TypedException(TypeErrors::CANCELLED, "Request cancelled");
+    }
+    bridgeMetrics.add(method, std::chrono::duration_cast<microseconds>(::now() - timeBegin), exception.numError != TypeErrors::NOT_ERROR);
+    return exception;
+}
+
+static std::string getMethodName(const QString &jsNameResult) {
+    const std::string RESULT_SUFFIX = "ResultJs";
+    const std::string name = jsNameResult.toStdString();
+    if (name.size() > RESULT_SUFFIX.size() && name.compare(name.size() - RESULT_SUFFIX.size(), RESULT_SUFFIX.size(), RESULT_SUFFIX) == 0) {
+        return name.substr(0, name.size() - RESULT_SUFFIX.size());
+    }
+    return name;
+}
+
+template<class WalletType, class LoadFunction>
+static std::unique_ptr<WalletType> findOrLoadWallet(WalletsCache &walletsCache, const QString &folder, const QString &address, const QString &password, const LoadFunction &load) {
+    // Ключ читается прямо из защищенного буфера кэша, без промежуточных копий
+    const std::shared_ptr<const LockedBuffer> secret = walletsCache.find(folder.toStdString(), address.toStdString(), password.toStdString());
+    if (secret != nullptr) {
+        return std::make_unique<WalletType>(secret->data(), secret->size());
+    }
+    return load();
+}
+
+static RsaKey findOrReadRsaKey(RsaKeysCache &rsaKeysCache, const QString &folder, const QString &address, const QString &password) {
+    RsaKey rsaKey = rsaKeysCache.find(folder.toStdString(), address.toStdString(), password.toStdString());
+    if (rsaKey == nullptr) {
+        rsaKey = Wallet::readRsaKey(folder, address.toStdString(), password.toStdString());
+        rsaKeysCache.add(folder.toStdString(), address.toStdString(), password.toStdString(), rsaKey, RSA_KEY_CACHE_TIME);
+    }
+    return rsaKey;
+}
+
 ////////////////
 /// METAHASH ///
 ////////////////
@@ -80,49 +146,30 @@ static TypedException apiVrapper(const Function &func) {
 void JavascriptWrapper::createWalletMTHS(QString requestId, QString password, QString walletPath, QString jsNameResult) {
     LOG << "Create wallet " << requestId;
 
-    const TypedException &exception = apiVrapper([this, &jsNameResult, &requestId, &password, &walletPath]() {
-        std::string publicKey;
-        std::string addr;
-        const std::string exampleMessage = "Example message " + std::to_string(rand());
-        std::string signature;
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::KEY_GENERATION, [this, requestId, password, walletPath, jsNameResult]() {
+        const TypedException &exception = apiVrapper(getMethodName(jsNameResult), [this, &jsNameResult, &requestId, &password, &walletPath]() {
+            std::string publicKey;
+            std::string addr;
+            const std::string exampleMessage = "Example message " + std::to_string(rand());
+            std::string signature;
 
-        CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        Wallet::createWallet(walletPath, password.toStdString(), publicKey, addr);
-
-        publicKey.clear();
-        Wallet wallet(walletPath, addr, password.toStdString());
-        signature = wallet.sign(exampleMessage, publicKey);
-
-        const QString jScript = jsNameResult + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(publicKey) + "\", " +
-            "\"" + QString::fromStdString(addr) + "\", " +
-            "\"" + QString::fromStdString(exampleMessage) + "\", " +
-            "\"" + QString::fromStdString(signature) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\", " +
-            "\"" + wallet.getFullPath() + "\"" +
-            ");";
-        //LOG << jScript.toStdString() << std::endl;
-        jsRunSig(jScript);
-    });
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            Wallet::createWallet(walletPath, password.toStdString(), publicKey, addr);
+            walletsIndex.invalidate(walletPath);
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(jsNameResult + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            "\"" + "" + "\", " +
-            "\"" + "" + "\", " +
-            "\"" + "" + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
-    }
+            publicKey.clear();
+            Wallet wallet(walletPath, addr, password.toStdString());
+            signature = wallet.sign(exampleMessage, publicKey);
+
+            runJsFunc(jsNameResult, requestId, {QString::fromStdString(publicKey), QString::fromStdString(addr), QString::fromStdString(exampleMessage), QString::fromStdString(signature)}, TypedException(TypeErrors::NOT_ERROR, ""), {wallet.getFullPath()});
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(jsNameResult, requestId, {QString(), QString(), QString(), QString(), QString()}, exception, {QString()});
+        }
 
-    LOG << "Create wallet ok " << requestId;
+        LOG << "Create wallet ok " << requestId;
+    });
 }
 
 void JavascriptWrapper::createWallet(QString requestId, QString password) {
@@ -157,57 +204,38 @@ void JavascriptWrapper::signMessageMHC(QString requestId, QString keyName, QStri
     signMessageMTHS(requestId, keyName, text, password, walletPathMth, "signMessageMHCResultJs");
 }
 
-static QString makeJsonWallets(const std::vector<std::pair<QString, QString>> &wallets) {
-    QJsonArray jsonArray;
-    for (const auto &r: wallets) {
-        jsonArray.push_back(r.first);
-    }
-    QJsonDocument json(jsonArray);
-    return json.toJson(QJsonDocument::Compact);
+void JavascriptWrapper::signMessagesBatch(QString requestId, QString keyName, QString jsonArrayOfTexts, QString password) {
+    signMessagesBatchMTHS(requestId, keyName, jsonArrayOfTexts, password, walletPathTmh, "signMessagesBatchResultJs");
 }
 
-static QString makeJsonWalletsAndPaths(const std::vector<std::pair<QString, QString>> &wallets) {
-    QJsonArray jsonArray;
-    for (const auto &r: wallets) {
-        QJsonObject val;
-        val.insert("address", r.first);
-        val.insert("path", r.second);
-        jsonArray.push_back(val);
-    }
-    QJsonDocument json(jsonArray);
-    return json.toJson(QJsonDocument::Compact);
+void JavascriptWrapper::signMessagesBatchMHC(QString requestId, QString keyName, QString jsonArrayOfTexts, QString password) {
+    signMessagesBatchMTHS(requestId, keyName, jsonArrayOfTexts, password, walletPathMth, "signMessagesBatchMHCResultJs");
 }
 
 QString JavascriptWrapper::getAllMTHSWalletsAndPathsJson(QString walletPath) {
-    try {
+    QString jsonStr;
+    const TypedException &exception = apiVrapper("getAllMTHSWalletsAndPathsJson", [&, this]() {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = Wallet::getAllWalletsInFolder(walletPath);
-        const QString jsonStr = makeJsonWalletsAndPaths(result);
-        LOG << "get mth wallets json " << jsonStr;
-        return jsonStr;
-    } catch (const Exception &e) {
-        LOG << "Error: " + e;
-        return "Error: " + QString::fromStdString(e);
-    } catch (...) {
-        LOG << "Unknown error";
-        return "Unknown error";
+        jsonStr = walletsIndex.getWalletsAndPathsJson(walletPath);
+        LOG << "get mth wallets json";
+    });
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        return "Error: " + QString::fromStdString(exception.description);
     }
+    return jsonStr;
 }
 
 QString JavascriptWrapper::getAllMTHSWalletsJson(QString walletPath) {
-    try {
+    QString jsonStr;
+    const TypedException &exception = apiVrapper("getAllMTHSWalletsJson", [&, this]() {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = Wallet::getAllWalletsInFolder(walletPath);
-        const QString jsonStr = makeJsonWallets(result);
-        LOG << "get mth wallets json " << jsonStr;
-        return jsonStr;
-    } catch (const Exception &e) {
-        LOG << "Error: " + e;
-        return "Error: " + QString::fromStdString(e);
-    } catch (...) {
-        LOG << "Unknown error";
-        return "Unknown error";
+        jsonStr = walletsIndex.getWalletsJson(walletPath);
+        LOG << "get mth wallets json";
+    });
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        return "Error: " + QString::fromStdString(exception.description);
     }
+    return jsonStr;
 }
 
 void JavascriptWrapper::signMessageMTHS(QString requestId, QString keyName, QString text, QString password, QString walletPath, QString jsNameResult) {
@@ -217,84 +245,131 @@ void JavascriptWrapper::signMessageMTHS(QString requestId, QString keyName, QStr
 
     const std::string textStr = text.toStdString();
 
-    const TypedException &exception = apiVrapper([this, &jsNameResult, &requestId, &keyName, &textStr, &password, &walletPath]() {
-        CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        Wallet wallet(walletPath, keyName.toStdString(), password.toStdString());
-        std::string publicKey;
-        const std::string signature = wallet.sign(textStr, publicKey);
-
-        jsRunSig(jsNameResult + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(signature) + "\", " +
-            "\"" + QString::fromStdString(publicKey) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, requestId, keyName, textStr, password, walletPath, jsNameResult]() {
+        const TypedException &exception = apiVrapper(getMethodName(jsNameResult), [this, &jsNameResult, &requestId, &keyName, &textStr, &password, &walletPath]() {
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<Wallet> wallet = findOrLoadWallet<Wallet>(walletsCache, walletPath, keyName, password, [&]() {
+                return std::make_unique<Wallet>(walletPath, keyName.toStdString(), password.toStdString());
+            });
+            std::string publicKey;
+            const std::string signature = wallet->sign(textStr, publicKey);
+
+            runJsFunc(jsNameResult, requestId, {QString::fromStdString(signature), QString::fromStdString(publicKey)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(jsNameResult, requestId, {QString(), QString()}, exception);
+        }
     });
+}
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(jsNameResult + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
-    }
+void JavascriptWrapper::signMessagesBatchMTHS(QString requestId, QString keyName, QString jsonArrayOfTexts, QString password, QString walletPath, QString jsNameResult) {
+    LOG << "Sign messages batch " << requestId << " " << keyName;
+
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, requestId, keyName, jsonArrayOfTexts, password, walletPath, jsNameResult]() {
+        const TypedException &exception = apiVrapper(getMethodName(jsNameResult), [&, this]() {
+            std::vector<std::string> texts;
+            const QJsonDocument document = QJsonDocument::fromJson(jsonArrayOfTexts.toUtf8());
+            CHECK(document.isArray(), "jsonArrayOfTexts not array");
+            const QJsonArray root = document.array();
+            for (const QJsonValue &text: root) {
+                CHECK(text.isString(), "text not string");
+                texts.emplace_back(text.toString().toStdString());
+            }
+
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<Wallet> wallet = findOrLoadWallet<Wallet>(walletsCache, walletPath, keyName, password, [&]() {
+                return std::make_unique<Wallet>(walletPath, keyName.toStdString(), password.toStdString());
+            });
+            std::string publicKey;
+            const std::vector<std::string> signatures = wallet->sign(texts, publicKey);
+
+            QJsonArray jsonSignatures;
+            for (const std::string &signature: signatures) {
+                jsonSignatures.push_back(QString::fromStdString(signature));
+            }
+            const QString signaturesStr = QString(QJsonDocument(jsonSignatures).toJson(QJsonDocument::Compact));
+
+            runJsFunc(jsNameResult, requestId, {signaturesStr, QString::fromStdString(publicKey)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(jsNameResult, requestId, {QString(), QString()}, exception);
+        }
+
+        LOG << "Sign messages batch ok " << requestId;
+    });
 }
 
 void JavascriptWrapper::createRsaKey(QString requestId, QString address, QString password) {
     const QString JS_NAME_RESULT = "createRsaKeyResultJs";
-    const TypedException &exception = apiVrapper([this, &JS_NAME_RESULT, &address, &requestId, &password]() {
-        CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::string publicKey = Wallet::createRsaKey(walletPathMth, address.toStdString(), password.toStdString());
-
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(publicKey) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
-    });
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::KEY_GENERATION, [this, JS_NAME_RESULT, requestId, address, password, walletPathMth=walletPathMth]() {
+        const TypedException &exception = apiVrapper("createRsaKey", [this, &JS_NAME_RESULT, &address, &requestId, &password, &walletPathMth]() {
+            CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
+            const std::string publicKey = Wallet::createRsaKey(walletPathMth, address.toStdString(), password.toStdString());
+            rsaKeysCache.remove(walletPathMth.toStdString(), address.toStdString());
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
-    }
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(publicKey)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
+    });
 }
 
 void JavascriptWrapper::decryptMessage(QString requestId, QString addr, QString password, QString encryptedMessageHex) {
     const QString JS_NAME_RESULT = "decryptMessageResultJs";
-    const TypedException &exception = apiVrapper([&, this]() {
-        CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::string message = Wallet::decryptMessage(walletPathMth, addr.toStdString(), password.toStdString(), encryptedMessageHex.toStdString());
-
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(message) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, addr, password, encryptedMessageHex, walletPathMth=walletPathMth]() {
+        const TypedException &exception = apiVrapper("decryptMessage", [&, this]() {
+            CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
+            const RsaKey rsaKey = findOrReadRsaKey(rsaKeysCache, walletPathMth, addr, password);
+            const std::string message = decrypt(rsaKey, encryptedMessageHex.toStdString());
+
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(message)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
     });
+}
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
-    }
+void JavascriptWrapper::decryptMessagesBatch(QString requestId, QString addr, QString password, QString jsonArrayOfHex) {
+    const QString JS_NAME_RESULT = "decryptMessagesBatchResultJs";
+
+    LOG << "Decrypt messages batch " << requestId << " " << addr;
+
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, addr, password, jsonArrayOfHex, walletPathMth=walletPathMth]() {
+        const TypedException &exception = apiVrapper("decryptMessagesBatch", [&, this]() {
+            std::vector<std::string> encryptedMessages;
+            const QJsonDocument document = QJsonDocument::fromJson(jsonArrayOfHex.toUtf8());
+            CHECK(document.isArray(), "jsonArrayOfHex not array");
+            const QJsonArray root = document.array();
+            for (const QJsonValue &message: root) {
+                CHECK(message.isString(), "message not string");
+                encryptedMessages.emplace_back(message.toString().toStdString());
+            }
+
+            CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
+            const RsaKey rsaKey = findOrReadRsaKey(rsaKeysCache, walletPathMth, addr, password);
+            const std::vector<std::string> messages = Wallet::decryptMessages(rsaKey, encryptedMessages);
+
+            QJsonArray jsonMessages;
+            for (const std::string &message: messages) {
+                jsonMessages.push_back(QString::fromStdString(message));
+            }
+            const QString messagesStr = QString(QJsonDocument(jsonMessages).toJson(QJsonDocument::Compact));
+
+            runJsFunc(JS_NAME_RESULT, requestId, {messagesStr}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
+
+        LOG << "Decrypt messages batch ok " << requestId;
+    });
 }
 
 ////////////////
@@ -302,37 +377,33 @@ void JavascriptWrapper::decryptMessage(QString requestId, QString addr, QString
 ////////////////
 
 void JavascriptWrapper::createWalletEth(QString requestId, QString password) {
+    createWalletEthImpl(requestId, password, QString::fromStdString(KDF_PROFILE_STANDARD), "createWalletEth");
+}
+
+void JavascriptWrapper::createWalletEthProfile(QString requestId, QString password, QString kdfProfile) {
+    createWalletEthImpl(requestId, password, kdfProfile, "createWalletEthProfile");
+}
+
+void JavascriptWrapper::createWalletEthImpl(QString requestId, QString password, QString kdfProfile, const std::string &method) {
     const QString JS_NAME_RESULT = "createWalletEthResultJs";
 
-    LOG << "Create wallet eth " << requestId;
+    LOG << "Create wallet eth " << requestId << " " << kdfProfile;
 
-    const TypedException &exception = apiVrapper([this, &JS_NAME_RESULT, &requestId, &password]() {
-        CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::string address = EthWallet::genPrivateKey(walletPathEth, password.toStdString());
-
-        const QString jScript = JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(address) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\", " +
-            "\"" + EthWallet::getFullPath(walletPathEth, address) + "\"" +
-            ");";
-        //LOG << jScript.toStdString() << std::endl;
-        jsRunSig(jScript);
-    });
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::KEY_GENERATION, [this, JS_NAME_RESULT, requestId, password, kdfProfile, method, walletPathEth=walletPathEth]() {
+        const TypedException &exception = apiVrapper(method, [this, &JS_NAME_RESULT, &requestId, &password, &kdfProfile, &walletPathEth]() {
+            CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
+            const std::string address = EthWallet::genPrivateKey(walletPathEth, password.toStdString(), kdfProfile.toStdString());
+            walletsIndex.invalidate(walletPathEth);
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
-    }
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(address)}, TypedException(TypeErrors::NOT_ERROR, ""), {EthWallet::getFullPath(walletPathEth, address)});
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception, {QString()});
+        }
 
-    LOG << "Create eth wallet ok " << requestId;
+        LOG << "Create eth wallet ok " << requestId;
+    });
 }
 
 void JavascriptWrapper::signMessageEth(QString requestId, QString address, QString password, QString nonce, QString gasPrice, QString gasLimit, QString to, QString value, QString data) {
@@ -340,36 +411,230 @@ void JavascriptWrapper::signMessageEth(QString requestId, QString address, QStri
 
     LOG << "Sign message eth";
 
-    const TypedException &exception = apiVrapper([&, this]() {
-        CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        EthWallet wallet(walletPathEth, address.toStdString(), password.toStdString());
-        const std::string result = wallet.SignTransaction(
-            nonce.toStdString(),
-            gasPrice.toStdString(),
-            gasLimit.toStdString(),
-            to.toStdString(),
-            value.toStdString(),
-            data.toStdString()
-        );
-
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(result) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, address, password, nonce, gasPrice, gasLimit, to, value, data, walletPathEth=walletPathEth]() {
+        const TypedException &exception = apiVrapper("signMessageEth", [&, this]() {
+            CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<EthWallet> wallet = findOrLoadWallet<EthWallet>(walletsCache, walletPathEth, address, password, [&]() {
+                return std::make_unique<EthWallet>(walletPathEth, address.toStdString(), password.toStdString());
+            });
+            const std::string result = wallet->SignTransaction(
+                nonce.toStdString(),
+                gasPrice.toStdString(),
+                gasLimit.toStdString(),
+                to.toStdString(),
+                value.toStdString(),
+                data.toStdString()
+            );
+
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(result)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
     });
+}
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
+static uint64_t parseHexUint64(const QString &name, const QString &value) {
+    CHECK(value.startsWith("0x"), "Incorrect " + name.toStdString() + " " + value.toStdString());
+    bool ok = false;
+    const uint64_t result = value.mid(2).toULongLong(&ok, 16);
+    CHECK(ok, "Incorrect " + name.toStdString() + " " + value.toStdString());
+    return result;
+}
+
+// Поля как в eth_signTransaction: type и chainId необязательны, по умолчанию legacy транзакция для основной сети
+static EthTransaction parseEthTransaction(const QJsonObject &txJson) {
+    const auto getField = [&txJson](const QString &name, bool isRequired) {
+        if (!isRequired && !txJson.contains(name)) {
+            return std::string();
+        }
+        CHECK(txJson.contains(name) && txJson.value(name).isString(), name.toStdString() + " field not found");
+        return txJson.value(name).toString().toStdString();
+    };
+
+    EthTransaction tx;
+    if (txJson.contains("type")) {
+        const uint64_t type = parseHexUint64("type", QString::fromStdString(getField("type", true)));
+        CHECK(type == (uint64_t)EthTransactionType::LEGACY || type == (uint64_t)EthTransactionType::EIP1559, "Unsupported transaction type " + std::to_string(type));
+        tx.type = (EthTransactionType)type;
+    }
+    if (txJson.contains("chainId")) {
+        tx.chainId = parseHexUint64("chainId", QString::fromStdString(getField("chainId", true)));
+    }
+    const bool isEip1559 = tx.type == EthTransactionType::EIP1559;
+    tx.nonce = getField("nonce", true);
+    tx.gasPrice = getField("gasPrice", !isEip1559);
+    tx.maxPriorityFeePerGas = getField("maxPriorityFeePerGas", isEip1559);
+    tx.maxFeePerGas = getField("maxFeePerGas", isEip1559);
+    tx.gasLimit = getField("gasLimit", true);
+    tx.to = getField("to", true);
+    tx.value = getField("value", true);
+    tx.data = getField("data", false);
+    if (txJson.contains("accessList")) {
+        CHECK(txJson.value("accessList").isArray(), "accessList not array");
+        for (const QJsonValue &entryJson: txJson.value("accessList").toArray()) {
+            CHECK(entryJson.isObject(), "accessList entry not object");
+            const QJsonObject entryObj = entryJson.toObject();
+            CHECK(entryObj.value("address").isString(), "accessList address field not found");
+            CHECK(entryObj.value("storageKeys").isArray(), "accessList storageKeys field not found");
+            EthAccessListEntry entry;
+            entry.address = entryObj.value("address").toString().toStdString();
+            for (const QJsonValue &key: entryObj.value("storageKeys").toArray()) {
+                CHECK(key.isString(), "storage key not string");
+                entry.storageKeys.emplace_back(key.toString().toStdString());
+            }
+            tx.accessList.emplace_back(entry);
+        }
+    }
+    return tx;
+}
+
+void JavascriptWrapper::signTransactionEth(QString requestId, QString address, QString password, QString jsonTx) {
+    const QString JS_NAME_RESULT = "signTransactionEthResultJs";
+
+    LOG << "Sign transaction eth " << requestId << " " << address;
+
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, address, password, jsonTx, walletPathEth=walletPathEth]() {
+        const TypedException &exception = apiVrapper("signTransactionEth", [&, this]() {
+            const QJsonDocument document = QJsonDocument::fromJson(jsonTx.toUtf8());
+            CHECK(document.isObject(), "jsonTx not object");
+            const EthTransaction transaction = parseEthTransaction(document.object());
+
+            CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<EthWallet> wallet = findOrLoadWallet<EthWallet>(walletsCache, walletPathEth, address, password, [&]() {
+                return std::make_unique<EthWallet>(walletPathEth, address.toStdString(), password.toStdString());
+            });
+            const std::string result = wallet->SignTransaction(transaction);
+
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(result)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
+    });
+}
+
+void JavascriptWrapper::signTransactionsEthBatch(QString requestId, QString address, QString password, QString jsonArrayOfTx) {
+    const QString JS_NAME_RESULT = "signTransactionsEthBatchResultJs";
+
+    LOG << "Sign transactions eth batch " << requestId << " " << address;
+
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, address, password, jsonArrayOfTx, walletPathEth=walletPathEth]() {
+        const TypedException &exception = apiVrapper("signTransactionsEthBatch", [&, this]() {
+            std::vector<EthTransaction> transactions;
+            const QJsonDocument document = QJsonDocument::fromJson(jsonArrayOfTx.toUtf8());
+            CHECK(document.isArray(), "jsonArrayOfTx not array");
+            const QJsonArray root = document.array();
+            for (const QJsonValue &value: root) {
+                CHECK(value.isObject(), "transaction not object");
+                transactions.emplace_back(parseEthTransaction(value.toObject()));
+            }
+
+            CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<EthWallet> wallet = findOrLoadWallet<EthWallet>(walletsCache, walletPathEth, address, password, [&]() {
+                return std::make_unique<EthWallet>(walletPathEth, address.toStdString(), password.toStdString());
+            });
+            const std::vector<std::string> signedTransactions = wallet->SignTransactions(transactions);
+
+            QJsonArray jsonTransactions;
+            for (const std::string &transaction: signedTransactions) {
+                jsonTransactions.push_back(QString::fromStdString(transaction));
+            }
+            const QString transactionsStr = QString(QJsonDocument(jsonTransactions).toJson(QJsonDocument::Compact));
+
+            runJsFunc(JS_NAME_RESULT, requestId, {transactionsStr}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
+
+        LOG << "Sign transactions eth batch ok " << requestId;
+    });
+}
+
+// JSON [{"to": "0x..", "amount": "0x.."}] или CSV со строками "to,amount", первая строка может быть заголовком
+static std::vector<Erc20Payout> parseErc20Payouts(const QString &payouts) {
+    std::vector<Erc20Payout> result;
+    const QString trimmed = payouts.trimmed();
+    if (trimmed.startsWith("[")) {
+        const QJsonDocument document = QJsonDocument::fromJson(trimmed.toUtf8());
+        CHECK(document.isArray(), "payouts not array");
+        for (const QJsonValue &value: document.array()) {
+            CHECK(value.isObject(), "payout not object");
+            const QJsonObject payoutJson = value.toObject();
+            CHECK(payoutJson.value("to").isString(), "to field not found");
+            CHECK(payoutJson.value("amount").isString(), "amount field not found");
+            result.push_back(Erc20Payout{payoutJson.value("to").toString().toStdString(), payoutJson.value("amount").toString().toStdString()});
+        }
+        return result;
     }
+
+    const QStringList lines = trimmed.split('\n', QString::SkipEmptyParts);
+    for (int i = 0; i < lines.size(); i++) {
+        const QStringList fields = lines[i].trimmed().split(',');
+        CHECK(fields.size() == 2, "Incorrect payout line " + lines[i].toStdString());
+        const QString to = fields[0].trimmed();
+        if (i == 0 && !to.startsWith("0x")) {
+            continue;
+        }
+        result.push_back(Erc20Payout{to.toStdString(), fields[1].trimmed().toStdString()});
+    }
+    return result;
+}
+
+void JavascriptWrapper::signErc20PayoutsEth(QString requestId, QString address, QString password, QString contractAddress, QString jsonTxParams, QString payouts) {
+    const QString JS_NAME_RESULT = "signErc20PayoutsEthResultJs";
+
+    LOG << "Sign erc20 payouts eth " << requestId << " " << address << " " << contractAddress;
+
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, address, password, contractAddress, jsonTxParams, payouts, walletPathEth=walletPathEth]() {
+        const TypedException &exception = apiVrapper("signErc20PayoutsEth", [&, this]() {
+            const QJsonDocument document = QJsonDocument::fromJson(jsonTxParams.toUtf8());
+            CHECK(document.isObject(), "jsonTxParams not object");
+            QJsonObject txParams = document.object();
+            txParams.insert("to", contractAddress);
+            txParams.insert("value", "0x0");
+            const EthTransaction baseTransaction = parseEthTransaction(txParams);
+
+            const std::vector<Erc20Payout> payoutsList = parseErc20Payouts(payouts);
+            CHECK(!payoutsList.empty(), "Empty payouts");
+            const std::vector<EthTransaction> transactions = EthWallet::makeErc20Payouts(baseTransaction, payoutsList);
+
+            CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<EthWallet> wallet = findOrLoadWallet<EthWallet>(walletsCache, walletPathEth, address, password, [&]() {
+                return std::make_unique<EthWallet>(walletPathEth, address.toStdString(), password.toStdString());
+            });
+            // nonce идут по возрастанию, поэтому порядок подписанных совпадает с порядком выплат
+            const std::vector<std::string> signedTransactions = wallet->SignTransactions(transactions);
+
+            QJsonArray jsonTransactions;
+            for (size_t i = 0; i < signedTransactions.size(); i++) {
+                QJsonObject txJson;
+                txJson.insert("nonce", QString::fromStdString(transactions[i].nonce));
+                txJson.insert("to", QString::fromStdString(payoutsList[i].to));
+                txJson.insert("amount", QString::fromStdString(payoutsList[i].amount));
+                txJson.insert("rawTransaction", QString::fromStdString(signedTransactions[i]));
+                jsonTransactions.push_back(txJson);
+            }
+            QJsonObject bundle;
+            bundle.insert("from", address);
+            bundle.insert("contract", contractAddress);
+            bundle.insert("chainId", "0x" + QString::number(baseTransaction.chainId, 16));
+            bundle.insert("transactions", jsonTransactions);
+            const QString bundleStr = QString(QJsonDocument(bundle).toJson(QJsonDocument::Compact));
+
+            runJsFunc(JS_NAME_RESULT, requestId, {bundleStr}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
+        }
+
+        LOG << "Sign erc20 payouts eth ok " << requestId;
+    });
 }
 
 /*void JavascriptWrapper::signMessageTokensEth(QString requestId, QString address, QString password, QString nonce, QString gasPrice, QString gasLimit, QString contractAddress, QString to, QString value) {
@@ -377,52 +642,40 @@ void JavascriptWrapper::signMessageEth(QString requestId, QString address, QStri
 
     LOG << "Sign message tokens eth" << std::endl;
 
-    const TypedException &exception = apiVrapper([&, this]() {
+    const TypedException &exception = apiVrapper("signMessageTokensEth", [&, this]() {
         const QString data = QString::fromStdString(EthWallet::makeErc20Data(value.toStdString(), to.toStdString()));
         signMessageEth(requestId, address, password, nonce, gasPrice, gasLimit, contractAddress, "0x0", data);
     });
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
+        runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
     }
 }*/
 
 QString JavascriptWrapper::getAllEthWalletsJson() {
-    try {
+    QString jsonStr;
+    const TypedException &exception = apiVrapper("getAllEthWalletsJson", [&, this]() {
         CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = EthWallet::getAllWalletsInFolder(walletPathEth);
-        const QString jsonStr = makeJsonWallets(result);
-        LOG << "get eth wallets json " << jsonStr;
-        return jsonStr;
-    } catch (const Exception &e) {
-        LOG << "Error: " + e;
-        return "Error: " + QString::fromStdString(e);
-    } catch (...) {
-        LOG << "Unknown error";
-        return "Unknown error";
+        jsonStr = walletsIndex.getWalletsJson(walletPathEth);
+        LOG << "get eth wallets json";
+    });
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        return "Error: " + QString::fromStdString(exception.description);
     }
+    return jsonStr;
 }
 
 QString JavascriptWrapper::getAllEthWalletsAndPathsJson() {
-    try {
+    QString jsonStr;
+    const TypedException &exception = apiVrapper("getAllEthWalletsAndPathsJson", [&, this]() {
         CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = EthWallet::getAllWalletsInFolder(walletPathEth);
-        const QString jsonStr = makeJsonWalletsAndPaths(result);
-        LOG << "get eth wallets json " << jsonStr;
-        return jsonStr;
-    } catch (const Exception &e) {
-        LOG << "Error: " + e;
-        return "Error: " + QString::fromStdString(e);
-    } catch (...) {
-        LOG << "Unknown error";
-        return "Unknown error";
+        jsonStr = walletsIndex.getWalletsAndPathsJson(walletPathEth);
+        LOG << "get eth wallets json";
+    });
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        return "Error: " + QString::fromStdString(exception.description);
     }
+    return jsonStr;
 }
 
 ///////////////
@@ -430,41 +683,57 @@ QString JavascriptWrapper::getAllEthWalletsAndPathsJson() {
 ///////////////
 
 void JavascriptWrapper::createWalletBtcPswd(QString requestId, QString password) {
+    createWalletBtcImpl(requestId, password, QString::fromStdString(KDF_PROFILE_STANDARD), "createWalletBtcPswd");
+}
+
+void JavascriptWrapper::createWalletBtcPswdProfile(QString requestId, QString password, QString kdfProfile) {
+    createWalletBtcImpl(requestId, password, kdfProfile, "createWalletBtcPswdProfile");
+}
+
+void JavascriptWrapper::createWalletBtcImpl(QString requestId, QString password, QString kdfProfile, const std::string &method) {
     const QString JS_NAME_RESULT = "createWalletBtcResultJs";
 
-    LOG << "Create wallet btc " << requestId;
+    LOG << "Create wallet btc " << requestId << " " << kdfProfile;
 
-    const TypedException &exception = apiVrapper([this, &JS_NAME_RESULT, &requestId, &password]() {
-        CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        const std::string address = BtcWallet::genPrivateKey(walletPathBtc, password).first;
-
-        const QString jScript = JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(address) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\", " +
-            "\"" + BtcWallet::getFullPath(walletPathBtc, address) + "\"" +
-            ");";
-        //LOG << jScript.toStdString() << std::endl;
-        jsRunSig(jScript);
-    });
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::KEY_GENERATION, [this, JS_NAME_RESULT, requestId, password, kdfProfile, method, walletPathBtc=walletPathBtc]() {
+        const TypedException &exception = apiVrapper(method, [this, &JS_NAME_RESULT, &requestId, &password, &kdfProfile, &walletPathBtc]() {
+            CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
+            const std::string address = BtcWallet::genPrivateKey(walletPathBtc, password, kdfProfile.toStdString()).first;
+            walletsIndex.invalidate(walletPathBtc);
 
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
-    }
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(address)}, TypedException(TypeErrors::NOT_ERROR, ""), {BtcWallet::getFullPath(walletPathBtc, address)});
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception, {QString()});
+        }
 
-    LOG << "Create btc wallet ok " << requestId;
+        LOG << "Create btc wallet ok " << requestId;
+    });
 }
 
 void JavascriptWrapper::createWalletBtc(QString requestId) {
-    createWalletBtcPswd(requestId, "");
+    createWalletBtcImpl(requestId, "", QString::fromStdString(KDF_PROFILE_STANDARD), "createWalletBtc");
+}
+
+static QJsonObject scryptParamsToJson(const ScryptParams &params) {
+    QJsonObject result;
+    result.insert("n", QJsonValue((qint64)params.n));
+    result.insert("r", QJsonValue((qint64)params.r));
+    result.insert("p", QJsonValue((qint64)params.p));
+    return result;
+}
+
+QString JavascriptWrapper::getKdfProfilesJson() {
+    QJsonArray profiles;
+    for (const std::string &name: getKdfProfileNames()) {
+        QJsonObject profile;
+        profile.insert("name", QString::fromStdString(name));
+        profile.insert("eth", scryptParamsToJson(getEthKdfProfile(name)));
+        profile.insert("btc", scryptParamsToJson(getBtcKdfProfile(name)));
+        profiles.push_back(profile);
+    }
+    return QJsonDocument(profiles).toJson(QJsonDocument::Compact);
 }
 
 void JavascriptWrapper::signMessageBtcPswd(QString requestId, QString address, QString password, QString jsonInputs, QString toAddress, QString value, QString estimateComissionInSatoshi, QString fees) {
@@ -472,53 +741,45 @@ void JavascriptWrapper::signMessageBtcPswd(QString requestId, QString address, Q
 
     LOG << "Sign message btc";
 
-    const TypedException &exception = apiVrapper([&, this]() {
-        std::vector<BtcInput> btcInputs;
-
-        const QJsonDocument document = QJsonDocument::fromJson(jsonInputs.toUtf8());
-        CHECK(document.isArray(), "jsonInputs not array");
-        const QJsonArray root = document.array();
-        for (const auto &jsonObj2: root) {
-            const QJsonObject jsonObj = jsonObj2.toObject();
-            BtcInput input;
-            CHECK(jsonObj.contains("value") && jsonObj.value("value").isString(), "value field not found");
-            input.outBalance = std::stoull(jsonObj.value("value").toString().toStdString());
-            CHECK(jsonObj.contains("scriptPubKey") && jsonObj.value("scriptPubKey").isString(), "scriptPubKey field not found");
-            input.scriptPubkey = jsonObj.value("scriptPubKey").toString().toStdString();
-            CHECK(jsonObj.contains("tx_index") && jsonObj.value("tx_index").isDouble(), "tx_index field not found");
-            input.spendoutnum = jsonObj.value("tx_index").toInt();
-            CHECK(jsonObj.contains("tx_hash") && jsonObj.value("tx_hash").isString(), "tx_hash field not found");
-            input.spendtxid = jsonObj.value("tx_hash").toString().toStdString();
-            btcInputs.emplace_back(input);
-        }
+    cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, address, password, jsonInputs, toAddress, value, estimateComissionInSatoshi, fees, walletPathBtc=walletPathBtc]() {
+        const TypedException &exception = apiVrapper("signMessageBtcPswd", [&, this]() {
+            std::vector<BtcInput> btcInputs;
+
+            const QJsonDocument document = QJsonDocument::fromJson(jsonInputs.toUtf8());
+            CHECK(document.isArray(), "jsonInputs not array");
+            const QJsonArray root = document.array();
+            for (const auto &jsonObj2: root) {
+                const QJsonObject jsonObj = jsonObj2.toObject();
+                BtcInput input;
+                CHECK(jsonObj.contains("value") && jsonObj.value("value").isString(), "value field not found");
+                input.outBalance = std::stoull(jsonObj.value("value").toString().toStdString());
+                CHECK(jsonObj.contains("scriptPubKey") && jsonObj.value("scriptPubKey").isString(), "scriptPubKey field not found");
+                input.scriptPubkey = jsonObj.value("scriptPubKey").toString().toStdString();
+                CHECK(jsonObj.contains("tx_index") && jsonObj.value("tx_index").isDouble(), "tx_index field not found");
+                input.spendoutnum = jsonObj.value("tx_index").toInt();
+                CHECK(jsonObj.contains("tx_hash") && jsonObj.value("tx_hash").isString(), "tx_hash field not found");
+                input.spendtxid = jsonObj.value("tx_hash").toString().toStdString();
+                btcInputs.emplace_back(input);
+            }
 
-        CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        BtcWallet wallet(walletPathBtc, address.toStdString(), password);
-        size_t estimateComissionInSatoshiInt = 0;
-        if (!estimateComissionInSatoshi.isEmpty()) {
-            CHECK(isDecimal(estimateComissionInSatoshi.toStdString()), "Not hex number value");
-            estimateComissionInSatoshiInt = std::stoll(estimateComissionInSatoshi.toStdString());
+            CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
+            const std::unique_ptr<BtcWallet> wallet = findOrLoadWallet<BtcWallet>(walletsCache, walletPathBtc, address, password, [&]() {
+                return std::make_unique<BtcWallet>(walletPathBtc, address.toStdString(), password);
+            });
+            size_t estimateComissionInSatoshiInt = 0;
+            if (!estimateComissionInSatoshi.isEmpty()) {
+                CHECK(isDecimal(estimateComissionInSatoshi.toStdString()), "Not hex number value");
+                estimateComissionInSatoshiInt = std::stoll(estimateComissionInSatoshi.toStdString());
+            }
+            const std::string result = wallet->buildTransaction(btcInputs, estimateComissionInSatoshiInt, value.toStdString(), fees.toStdString(), toAddress.toStdString());
+
+            runJsFunc(JS_NAME_RESULT, requestId, {QString::fromStdString(result)}, TypedException(TypeErrors::NOT_ERROR, ""));
+        });
+
+        if (exception.numError != TypeErrors::NOT_ERROR) {
+            runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
         }
-        const std::string result = wallet.buildTransaction(btcInputs, estimateComissionInSatoshiInt, value.toStdString(), fees.toStdString(), toAddress.toStdString());
-
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + QString::fromStdString(result) + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
     });
-
-    if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
-    }
 }
 
 void JavascriptWrapper::signMessageBtc(QString requestId, QString address, QString jsonInputs, QString toAddress, QString value, QString estimateComissionInSatoshi, QString fees) {
@@ -526,35 +787,29 @@ void JavascriptWrapper::signMessageBtc(QString requestId, QString address, QStri
 }
 
 QString JavascriptWrapper::getAllBtcWalletsJson() {
-    try {
+    QString jsonStr;
+    const TypedException &exception = apiVrapper("getAllBtcWalletsJson", [&, this]() {
         CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = BtcWallet::getAllWalletsInFolder(walletPathBtc);
-        const QString jsonStr = makeJsonWallets(result);
-        LOG << "get btc wallets json " << jsonStr;
-        return jsonStr;
-    } catch (const Exception &e) {
-        LOG << "Error: " + e;
-        return "Error: " + QString::fromStdString(e);
-    } catch (...) {
-        LOG << "Unknown error";
-        return "Unknown error";
+        jsonStr = walletsIndex.getWalletsJson(walletPathBtc);
+        LOG << "get btc wallets json";
+    });
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        return "Error: " + QString::fromStdString(exception.description);
     }
+    return jsonStr;
 }
 
 QString JavascriptWrapper::getAllBtcWalletsAndPathsJson() {
-    try {
+    QString jsonStr;
+    const TypedException &exception = apiVrapper("getAllBtcWalletsAndPathsJson", [&, this]() {
         CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = BtcWallet::getAllWalletsInFolder(walletPathBtc);
-        const QString jsonStr = makeJsonWalletsAndPaths(result);
-        LOG << "get btc wallets json " << jsonStr;
-        return jsonStr;
-    } catch (const Exception &e) {
-        LOG << "Error: " + e;
-        return "Error: " + QString::fromStdString(e);
-    } catch (...) {
-        LOG << "Unknown error";
-        return "Unknown error";
+        jsonStr = walletsIndex.getWalletsAndPathsJson(walletPathBtc);
+        LOG << "get btc wallets json";
+    });
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        return "Error: " + QString::fromStdString(exception.description);
     }
+    return jsonStr;
 }
 
 //////////////
@@ -566,24 +821,14 @@ void JavascriptWrapper::updateAndReloadApplication() {
 
     LOG << "Reload application ";
 
-    const TypedException &exception = apiVrapper([&, this]() {
+    const TypedException &exception = apiVrapper("updateAndReloadApplication", [&, this]() {
         updateAndRestart();
 
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + "Ok" + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
+        runJsFunc(JS_NAME_RESULT, QJsonValue(), {"Ok"}, TypedException(TypeErrors::NOT_ERROR, ""));
     });
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + "Not ok" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
+        runJsFunc(JS_NAME_RESULT, QJsonValue(), {"Not ok"}, exception);
     }
 }
 
@@ -595,14 +840,90 @@ void JavascriptWrapper::qtOpenInBrowser(QString url) {
 void JavascriptWrapper::getWalletFolders() {
     LOG << "getWalletFolders ";
     const QString JS_NAME_RESULT = "walletFoldersJs";
-    jsRunSig(JS_NAME_RESULT + "(" +
-        "\"" + walletDefaultPath + "\", " +
-        "\"" + walletPath + "\", " +
-        "\"" + userName + "\", " +
-        QString::fromStdString(std::to_string(0)) + ", " +
-        "\"" + QString::fromStdString("") + "\"" +
-        ");"
-    );
+    runJsFunc(JS_NAME_RESULT, QJsonValue(), {walletDefaultPath, walletPath, userName}, TypedException(TypeErrors::NOT_ERROR, ""));
+}
+
+QString JavascriptWrapper::getWalletPathForCurrency(const QString &currency) const {
+    if (currency == "tmh") {
+        return walletPathTmh;
+    } else if (currency == "mhc") {
+        return walletPathMth;
+    } else if (currency == "eth") {
+        return walletPathEth;
+    } else if (currency == "btc") {
+        return walletPathBtc;
+    } else {
+        throwErr("Incorrect currency " + currency.toStdString());
+    }
+}
+
+void JavascriptWrapper::unlockWallet(QString requestId, QString currency, QString address, QString password, int timeoutSeconds) {
+    const QString JS_NAME_RESULT = "unlockWalletResultJs";
+
+    LOG << "Unlock wallet " << currency << " " << address;
+
+    const TypedException &exception = apiVrapper("unlockWallet", [&, this]() {
+        const QString folder = getWalletPathForCurrency(currency);
+        CHECK(!folder.isNull() && !folder.isEmpty(), "Incorrect path to wallet: empty");
+        const seconds ttl = timeoutSeconds <= 0 ? WALLET_UNLOCK_DEFAULT_TIME : std::min(seconds(timeoutSeconds), WALLET_UNLOCK_MAX_TIME);
+
+        cryptoExecutor.post(requestId.toStdString(), CryptoExecutor::Priority::INTERACTIVE, [this, JS_NAME_RESULT, requestId, currency, address, password, folder, ttl]() {
+            const TypedException &exception = apiVrapper("unlockWallet.decrypt", [&, this]() {
+                // Ключ копируется из кошелька сразу в буфер кэша
+                if (currency == "eth") {
+                    const EthWallet wallet(folder, address.toStdString(), password.toStdString());
+                    const LockedBuffer &secret = wallet.getRawPrivateKey();
+                    walletsCache.unlock(folder.toStdString(), address.toStdString(), password.toStdString(), secret.data(), secret.size(), ttl);
+                } else if (currency == "btc") {
+                    const BtcWallet wallet(folder, address.toStdString(), password);
+                    const std::string &secret = wallet.getWif();
+                    walletsCache.unlock(folder.toStdString(), address.toStdString(), password.toStdString(), secret.data(), secret.size(), ttl);
+                } else {
+                    std::string secret = Wallet(folder, address.toStdString(), password.toStdString()).getPrivateKeyBinary();
+                    walletsCache.unlock(folder.toStdString(), address.toStdString(), password.toStdString(), secret, ttl);
+                    CryptoPP::SecureWipeBuffer((byte*)&secret[0], secret.size());
+                }
+
+                runJsFunc(JS_NAME_RESULT, requestId, QJsonArray(), TypedException(TypeErrors::NOT_ERROR, ""));
+            });
+
+            if (exception.numError != TypeErrors::NOT_ERROR) {
+                runJsFunc(JS_NAME_RESULT, requestId, QJsonArray(), exception);
+            }
+
+            LOG << "Unlock wallet ok " << requestId;
+        });
+    });
+
+    if (exception.numError != TypeErrors::NOT_ERROR) {
+        runJsFunc(JS_NAME_RESULT, requestId, QJsonArray(), exception);
+    }
+}
+
+void JavascriptWrapper::cancelRequest(QString requestId) {
+    LOG << "Cancel request " << requestId;
+    cryptoExecutor.cancel(requestId.toStdString());
+}
+
+void JavascriptWrapper::lockWallet(QString currency, QString address) {
+    LOG << "Lock wallet " << currency << " " << address;
+
+    apiVrapper("lockWallet", [&, this]() {
+        walletsCache.lock(getWalletPathForCurrency(currency).toStdString(), address.toStdString());
+    });
+}
+
+void JavascriptWrapper::lockAllWallets() {
+    LOG << "Lock all wallets";
+    walletsCache.lockAll();
+    rsaKeysCache.clear();
+    libscrypt_arena_release_all();
+}
+
+void JavascriptWrapper::onWalletsCacheTimer() {
+    walletsCache.removeExpired();
+    rsaKeysCache.removeExpired();
+    libscrypt_arena_release_idle();
 }
 
 bool JavascriptWrapper::migrateKeysToPath(QString newPath) {
@@ -616,13 +937,18 @@ bool JavascriptWrapper::migrateKeysToPath(QString newPath) {
     copyRecursively(QDir(prevPath).filePath(WALLET_PATH_TMH), QDir(newPath).filePath(WALLET_PATH_TMH), false);
     copyRecursively(prevPath, QDir(newPath).filePath(WALLET_PATH_TMH), false);
 
+    walletsIndex.invalidateAll();
+
     return true;
 }
 
 void JavascriptWrapper::setPaths(QString newPatch, QString newUserName) {
     const QString JS_NAME_RESULT = "setPathsJs";
 
-    const TypedException &exception = apiVrapper([&, this]() {
+    walletsCache.lockAll();
+    rsaKeysCache.clear();
+
+    const TypedException &exception = apiVrapper("setPaths", [&, this]() {
         userName = newUserName;
         walletPath = newPatch;
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
@@ -644,21 +970,17 @@ void JavascriptWrapper::setPaths(QString newPatch, QString newUserName) {
             oldTmhPath.removeRecursively();
         }
 
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + "Ok" + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");"
-        );
+        walletsIndex.clear();
+        walletsIndex.addFolder(walletPathTmh, &Wallet::getWalletFromFile);
+        walletsIndex.addFolder(walletPathMth, &Wallet::getWalletFromFile);
+        walletsIndex.addFolderBatch(walletPathEth, &EthWallet::getWalletsFromFiles);
+        walletsIndex.addFolder(walletPathBtc, &BtcWallet::getWalletFromFile);
+
+        runJsFunc(JS_NAME_RESULT, QJsonValue(), {"Ok"}, TypedException(TypeErrors::NOT_ERROR, ""));
     });
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
-        jsRunSig(JS_NAME_RESULT + "(" +
-            "\"" + "Not ok" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
+        runJsFunc(JS_NAME_RESULT, QJsonValue(), {"Not ok"}, exception);
     }
 }
 
@@ -696,6 +1018,7 @@ QString JavascriptWrapper::restoreKeys(QString caption) {
         reply = QMessageBox::question(widget_, "caption", "Restore backup " + QString::fromStdString(text) + "?", QMessageBox::Yes|QMessageBox::No);
         if (reply == QMessageBox::Yes) {
             ::restoreKeys(file, walletPath);
+            walletsIndex.invalidateAll();
         }
         return "";
     } catch (const Exception &e) {
@@ -710,11 +1033,7 @@ QString JavascriptWrapper::restoreKeys(QString caption) {
 void JavascriptWrapper::getMachineUid() {
     const QString JS_NAME_RESULT = "machineUidJs";
 
-    const QString uid = "\"" + hardwareId + "\"";
-    jsRunSig(JS_NAME_RESULT + "(" +
-        uid + "" +
-        ");"
-    );
+    runJsFunc(JS_NAME_RESULT, QJsonValue(), {hardwareId}, TypedException(TypeErrors::NOT_ERROR, ""));
 }
 
 void JavascriptWrapper::setHasNativeToolbarVariable() {
@@ -742,38 +1061,20 @@ void JavascriptWrapper::getIpsServers(QString requestId, QString type, int lengt
 
     LOG << "get ips servers " << requestId;
 
-    const TypedException &exception = apiVrapper([this, &JS_NAME_RESULT, &requestId, &type, length, count]() {
+    const TypedException &exception = apiVrapper("getIpsServers", [this, &JS_NAME_RESULT, &requestId, &type, length, count]() {
         const std::vector<QString> result = nsLookup.getRandom(type, length, count);
 
-        QString resultStr = "[";
-        bool isFirst = true;
+        QJsonArray resultJson;
         for (const QString &r: result) {
-            if (!isFirst) {
-                resultStr += ", ";
-            }
-            isFirst = false;
-            resultStr += "\\\"" + r + "\\\"";
+            resultJson.push_back(r);
         }
-        resultStr += "]";
-
-        const QString jScript = JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + resultStr + "\", " +
-            QString::fromStdString(std::to_string(TypeErrors::NOT_ERROR)) + ", " +
-            "\"" + "" + "\"" +
-            ");";
-        //LOG << jScript.toStdString() << std::endl;
-        jsRunSig(jScript);
+        const QString resultStr = QString(QJsonDocument(resultJson).toJson(QJsonDocument::Compact));
+
+        runJsFunc(JS_NAME_RESULT, requestId, {resultStr}, TypedException(TypeErrors::NOT_ERROR, ""));
     });
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
-        runJs(JS_NAME_RESULT + "(" +
-            "\"" + requestId + "\", " +
-            "\"" + "" + "\", " +
-            QString::fromStdString(std::to_string(exception.numError)) + ", " +
-            "\"" + QString::fromStdString(exception.description) + "\"" +
-            ");"
-        );
+        runJsFunc(JS_NAME_RESULT, requestId, {QString()}, exception);
     }
 
     LOG << "get ips servers ok " << requestId;
@@ -786,3 +1087,94 @@ void JavascriptWrapper::setUserName(const QString &userName) {
 void JavascriptWrapper::runJs(const QString &script) {
     emit jsRunSig(script);
 }
+
+static QString toJsArg(const QJsonValue &value) {
+    const QByteArray json = QJsonDocument(QJsonArray{value}).toJson(QJsonDocument::Compact);
+    return QString::fromUtf8(json.mid(1, json.size() - 2));
+}
+
+void JavascriptWrapper::runJsFunc(const QString &function, const QJsonValue &requestId, const QJsonArray &args, const TypedException &exception, const QJsonArray &argsAfterError) {
+    if (isStructuredResults) {
+        QJsonArray payload = args;
+        for (const QJsonValue &arg: argsAfterError) {
+            payload.push_back(arg);
+        }
+        QJsonObject error;
+        error.insert("code", int(exception.numError));
+        error.insert("message", QString::fromStdString(exception.description));
+
+        QJsonObject result;
+        result.insert("method", function);
+        result.insert("requestId", requestId);
+        result.insert("payload", payload);
+        result.insert("error", error);
+
+        bool isFirst;
+        {
+            std::lock_guard<std::mutex> lock(pendingResultsMut);
+            isFirst = pendingResults.isEmpty();
+            if (isFirst) {
+                pendingResultsBegin = ::now();
+            }
+            pendingResults.push_back(result);
+        }
+        if (isFirst) {
+            QMetaObject::invokeMethod(this, "onFlushResults", Qt::QueuedConnection);
+        }
+        return;
+    }
+
+    QStringList jsArgs;
+    if (!requestId.isNull()) {
+        jsArgs.append(toJsArg(requestId));
+    }
+    for (const QJsonValue &arg: args) {
+        jsArgs.append(toJsArg(arg));
+    }
+    jsArgs.append(QString::number(int(exception.numError)));
+    jsArgs.append(toJsArg(QString::fromStdString(exception.description)));
+    for (const QJsonValue &arg: argsAfterError) {
+        jsArgs.append(toJsArg(arg));
+    }
+    runJs(function + "(" + jsArgs.join(", ") + ");");
+}
+
+void JavascriptWrapper::onFlushResults() {
+    QJsonArray results;
+    time_point timeBegin;
+    {
+        std::lock_guard<std::mutex> lock(pendingResultsMut);
+        std::swap(results, pendingResults);
+        timeBegin = pendingResultsBegin;
+    }
+    if (!results.isEmpty()) {
+        emit resultsSig(results);
+        bridgeMetrics.add("resultsDelivery", std::chrono::duration_cast<microseconds>(::now() - timeBegin), false);
+    }
+}
+
+QString JavascriptWrapper::getBridgeMetricsJson() {
+    return bridgeMetrics.getJson();
+}
+
+void JavascriptWrapper::setMetricsFile(const QString &path) {
+    LOG << "Bridge metrics file " << path;
+    metricsFile = path;
+    QTimer *metricsTimer = new QTimer(this);
+    CHECK(connect(metricsTimer, SIGNAL(timeout()), this, SLOT(onMetricsTimer())), "not connect timeout");
+    metricsTimer->setInterval(milliseconds(METRICS_FILE_PERIOD).count());
+    metricsTimer->start();
+}
+
+void JavascriptWrapper::onMetricsTimer() {
+    try {
+        writeToFile(metricsFile, bridgeMetrics.getJson().toStdString(), false);
+    } catch (const Exception &e) {
+        LOG << "Error " << e;
+    }
+}
+
+void JavascriptWrapper::setStructuredResults(bool isEnabled) {
+    LOG << "Structured results " << isEnabled;
+    isStructuredResults = isEnabled;
+}
@@ -3,6 +3,17 @@
 
 #include <QObject>
 #include <QString>
+#include <QJsonArray>
+#include <QJsonValue>
+
+#include <atomic>
+#include <mutex>
+
+#include "CryptoExecutor.h"
+#include "WalletsCache.h"
+#include "WalletsIndex.h"
+#include "TypedException.h"
+#include "BridgeMetrics.h"
 
 class NsLookup;
 
@@ -14,10 +25,21 @@ public:
 
     void setWidget(QWidget *widget);
 
+    /*
+       Раз в минуту записывать метрики моста в файл
+       */
+    void setMetricsFile(const QString &path);
+
 signals:
 
     void jsRunSig(QString jsString);
 
+    /*
+       Результаты в виде массива объектов {method, requestId, payload, error}.
+       Все результаты, пришедшие за одну итерацию event loop, отправляются одним сигналом
+       */
+    void resultsSig(QJsonArray results);
+
     void setHasNativeToolbarVariableSig();
 
     void setCommandLineTextSig(QString text);
@@ -28,6 +50,23 @@ signals:
 
     void lineEditReturnPressedSig(QString text);
 
+public slots:
+
+    /*
+       Страница, подписавшаяся на resultsSig, включает доставку результатов через него вместо вызова js функций
+       */
+    Q_INVOKABLE void setStructuredResults(bool isEnabled);
+
+    /*
+       Прерывает запрос: результат придет с ошибкой CANCELLED. Прогресс долгих запросов приходит в requestProgressJs(requestId, done, total)
+       */
+    Q_INVOKABLE void cancelRequest(QString requestId);
+
+    /*
+       {method: {count, errors, avg_us, p50_us, p95_us, p99_us, max_us}}
+       */
+    Q_INVOKABLE QString getBridgeMetricsJson();
+
 public slots:
 
     Q_INVOKABLE void createWallet(QString requestId, QString password);
@@ -38,6 +77,8 @@ public slots:
 
     Q_INVOKABLE void signMessage(QString requestId, QString keyName, QString text, QString password);
 
+    Q_INVOKABLE void signMessagesBatch(QString requestId, QString keyName, QString jsonArrayOfTexts, QString password);
+
 public slots:
 
     Q_INVOKABLE void createWalletMHC(QString requestId, QString password);
@@ -48,18 +89,30 @@ public slots:
 
     Q_INVOKABLE void signMessageMHC(QString requestId, QString keyName, QString text, QString password);
 
+    Q_INVOKABLE void signMessagesBatchMHC(QString requestId, QString keyName, QString jsonArrayOfTexts, QString password);
+
 public slots:
 
     Q_INVOKABLE void createRsaKey(QString requestId, QString address, QString password);
 
     Q_INVOKABLE void decryptMessage(QString requestId, QString addr, QString password, QString encryptedMessageHex);
 
+    Q_INVOKABLE void decryptMessagesBatch(QString requestId, QString addr, QString password, QString jsonArrayOfHex);
+
 public slots:
 
     Q_INVOKABLE void createWalletEth(QString requestId, QString password);
 
+    Q_INVOKABLE void createWalletEthProfile(QString requestId, QString password, QString kdfProfile);
+
     Q_INVOKABLE void signMessageEth(QString requestId, QString address, QString password, QString nonce, QString gasPrice, QString gasLimit, QString to, QString value, QString data);
 
+    Q_INVOKABLE void signTransactionEth(QString requestId, QString address, QString password, QString jsonTx);
+
+    Q_INVOKABLE void signTransactionsEthBatch(QString requestId, QString address, QString password, QString jsonArrayOfTx);
+
+    Q_INVOKABLE void signErc20PayoutsEth(QString requestId, QString address, QString password, QString contractAddress, QString jsonTxParams, QString payouts);
+
     //Q_INVOKABLE void signMessageTokensEth(QString requestId, QString address, QString password, QString nonce, QString gasPrice, QString gasLimit, QString contractAddress, QString to, QString value);
 
     Q_INVOKABLE QString getAllEthWalletsJson();
@@ -72,6 +125,10 @@ public slots:
 
     Q_INVOKABLE void createWalletBtcPswd(QString requestId, QString password);
 
+    Q_INVOKABLE void createWalletBtcPswdProfile(QString requestId, QString password, QString kdfProfile);
+
+    Q_INVOKABLE QString getKdfProfilesJson();
+
     Q_INVOKABLE void signMessageBtc(QString requestId, QString address, QString jsonInputs, QString toAddress, QString value, QString estimateComissionInSatoshi, QString fees);
 
     Q_INVOKABLE void signMessageBtcPswd(QString requestId, QString address, QString password, QString jsonInputs, QString toAddress, QString value, QString estimateComissionInSatoshi, QString fees);
@@ -80,6 +137,18 @@ public slots:
 
     Q_INVOKABLE QString getAllBtcWalletsAndPathsJson();
 
+public slots:
+
+    /*
+       Расшифровывает ключ один раз и держит его в памяти timeoutSeconds секунд.
+       currency: tmh, mhc, eth, btc
+       */
+    Q_INVOKABLE void unlockWallet(QString requestId, QString currency, QString address, QString password, int timeoutSeconds);
+
+    Q_INVOKABLE void lockWallet(QString currency, QString address);
+
+    Q_INVOKABLE void lockAllWallets();
+
 public slots:
 
     Q_INVOKABLE bool migrateKeysToPath(QString newPath);
@@ -116,6 +185,14 @@ public slots:
 
     Q_INVOKABLE void getIpsServers(QString requestId, QString type, int length, int count);
 
+private slots:
+
+    void onWalletsCacheTimer();
+
+    void onFlushResults();
+
+    void onMetricsTimer();
+
 private:
 
     void createWalletMTHS(QString requestId, QString password, QString walletPath, QString jsNameResult);
@@ -126,8 +203,26 @@ private:
 
     void signMessageMTHS(QString requestId, QString keyName, QString text, QString password, QString walletPath, QString jsNameResult);
 
+    void signMessagesBatchMTHS(QString requestId, QString keyName, QString jsonArrayOfTexts, QString password, QString walletPath, QString jsNameResult);
+
+    // method - имя для метрик, у старых точек входа оно прежнее
+    void createWalletEthImpl(QString requestId, QString password, QString kdfProfile, const std::string &method);
+
+    void createWalletBtcImpl(QString requestId, QString password, QString kdfProfile, const std::string &method);
+
     void runJs(const QString &script);
 
+    template<class Function>
+    TypedException apiVrapper(const std::string &method, const Function &func);
+
+    /*
+       requestId может быть null, если функция его не принимает.
+       Для старых страниц вызывает function(requestId, args..., errorNum, errorMessage, argsAfterError...)
+       */
+    void runJsFunc(const QString &function, const QJsonValue &requestId, const QJsonArray &args, const TypedException &exception, const QJsonArray &argsAfterError = QJsonArray());
+
+    QString getWalletPathForCurrency(const QString &currency) const;
+
 private:
 
     NsLookup &nsLookup;
@@ -152,6 +247,26 @@ private:
 
     QWidget *widget_ = nullptr;
 
+    WalletsCache walletsCache;
+
+    RsaKeysCache rsaKeysCache;
+
+    WalletsIndex walletsIndex;
+
+    std::atomic<bool> isStructuredResults{false};
+
+    std::mutex pendingResultsMut;
+
+    QJsonArray pendingResults;
+
+    time_point pendingResultsBegin;
+
+    BridgeMetrics bridgeMetrics;
+
+    QString metricsFile;
+
+    CryptoExecutor cryptoExecutor;
+
 };
 
 #endif // JAVASCRIPTWRAPPER_H
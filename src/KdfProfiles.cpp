@@ -0,0 +1,43 @@
+#include "KdfProfiles.h"
+
+#include "check.h"
+
+#include "ethtx/const.h"
+
+struct KdfProfile {
+    const std::string &name;
+    ScryptParams eth;
+    ScryptParams btc;
+};
+
+// Память scrypt - 128 * r * N байт на каждую из p линий
+const static KdfProfile KDF_PROFILES[] = {
+    {KDF_PROFILE_INTERACTIVE, {16384, 8, 1}, {16384, 8, 1}},
+    {KDF_PROFILE_STANDARD, {SCRYPT_DEFAULT_N, SCRYPT_DEFAULT_r, SCRYPT_DEFAULT_p}, BIP38_SCRYPT_PARAMS},
+    {KDF_PROFILE_PARANOID, {262144, 8, 4}, {65536, 8, 8}},
+};
+
+static const KdfProfile& findKdfProfile(const std::string &name) {
+    for (const KdfProfile &profile: KDF_PROFILES) {
+        if (profile.name == name) {
+            return profile;
+        }
+    }
+    throwErr("Unknown kdf profile " + name);
+}
+
+std::vector<std::string> getKdfProfileNames() {
+    std::vector<std::string> result;
+    for (const KdfProfile &profile: KDF_PROFILES) {
+        result.emplace_back(profile.name);
+    }
+    return result;
+}
+
+ScryptParams getEthKdfProfile(const std::string &name) {
+    return findKdfProfile(name).eth;
+}
+
+ScryptParams getBtcKdfProfile(const std::string &name) {
+    return findKdfProfile(name).btc;
+}
@@ -0,0 +1,43 @@
+#ifndef KDFPROFILES_H
+#define KDFPROFILES_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+struct ScryptParams {
+    uint64_t n;
+    uint32_t r;
+    uint32_t p;
+
+    bool operator==(const ScryptParams &second) const {
+        return n == second.n && r == second.r && p == second.p;
+    }
+
+    bool operator!=(const ScryptParams &second) const {
+        return !(*this == second);
+    }
+};
+
+/*
+   Параметры BIP38. Ключ, зашифрованный с другими, расшифруют только кошельки, знающие про запись параметров
+   */
+const ScryptParams BIP38_SCRYPT_PARAMS = {16384, 8, 8};
+
+/*
+   Именованные профили scrypt для новых ключей.
+   standard - прежние параметры (keystore v3 для eth, BIP38 для btc),
+   interactive - быстрая разблокировка на слабом железе, paranoid - дороже для перебора
+   */
+const std::string KDF_PROFILE_INTERACTIVE = "interactive";
+const std::string KDF_PROFILE_STANDARD = "standard";
+const std::string KDF_PROFILE_PARANOID = "paranoid";
+
+std::vector<std::string> getKdfProfileNames();
+
+ScryptParams getEthKdfProfile(const std::string &name);
+
+ScryptParams getBtcKdfProfile(const std::string &name);
+
+#endif // KDFPROFILES_H
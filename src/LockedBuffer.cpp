@@ -0,0 +1,65 @@
+#include "LockedBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef TARGET_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <cryptopp/misc.h>
+
+#include "check.h"
+#include "Log.h"
+
+const static size_t PAGE_SIZE_BYTES = 4096;
+
+LockedBuffer::LockedBuffer(size_t size)
+    : length(size)
+{
+    // Отдельные страницы на каждый буфер, чтобы munlock одного не снимал блокировку с соседнего
+    capacity = std::max((size + PAGE_SIZE_BYTES - 1) / PAGE_SIZE_BYTES * PAGE_SIZE_BYTES, PAGE_SIZE_BYTES);
+#ifdef TARGET_WINDOWS
+    buffer = (char*)VirtualAlloc(nullptr, capacity, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    CHECK(buffer != nullptr, "Not allocate locked buffer");
+    isLocked = VirtualLock(buffer, capacity) != 0;
+#else
+    void *ptr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(ptr != MAP_FAILED, "Not allocate locked buffer");
+    buffer = (char*)ptr;
+    isLocked = mlock(buffer, capacity) == 0;
+#ifdef MADV_DONTDUMP
+    madvise(buffer, capacity, MADV_DONTDUMP);
+#endif
+#endif
+    if (!isLocked) {
+        LOG << "Warning: memory for wallet key not locked";
+    }
+}
+
+LockedBuffer::LockedBuffer(const std::string &data)
+    : LockedBuffer(data.data(), data.size())
+{}
+
+LockedBuffer::LockedBuffer(const char *data, size_t size)
+    : LockedBuffer(size)
+{
+    std::memcpy(buffer, data, size);
+}
+
+LockedBuffer::~LockedBuffer() {
+    CryptoPP::SecureWipeBuffer((byte*)buffer, capacity);
+#ifdef TARGET_WINDOWS
+    if (isLocked) {
+        VirtualUnlock(buffer, capacity);
+    }
+    VirtualFree(buffer, 0, MEM_RELEASE);
+#else
+    if (isLocked) {
+        munlock(buffer, capacity);
+    }
+    munmap(buffer, capacity);
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef LOCKEDBUFFER_H
+#define LOCKEDBUFFER_H
+
+#include <string>
+
+/*
+   Буфер в памяти, запрещенной к выгрузке в swap. При удалении затирается нулями.
+   */
+class LockedBuffer {
+public:
+
+    // Буфер из size нулей
+    explicit LockedBuffer(size_t size);
+
+    explicit LockedBuffer(const std::string &data);
+
+    LockedBuffer(const char *data, size_t size);
+
+    ~LockedBuffer();
+
+    LockedBuffer(const LockedBuffer &) = delete;
+    LockedBuffer& operator=(const LockedBuffer &) = delete;
+
+    char* data() {
+        return buffer;
+    }
+
+    const char* data() const {
+        return buffer;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+
+    char *buffer = nullptr;
+
+    size_t length = 0;
+
+    size_t capacity = 0;
+
+    bool isLocked = false;
+
+};
+
+#endif // LOCKEDBUFFER_H
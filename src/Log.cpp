@@ -5,6 +5,8 @@
 
 std::ofstream __log_file__;
 
+std::recursive_mutex __log_mutex__;
+
 void initLog() {
 #ifdef TARGET_WINDOWS
     auto path = QDir(QApplication::applicationDirPath()).filePath("log.txt").toStdWString();
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iostream>
 #include <ctime>
+#include <mutex>
 
 #include <QString>
 
@@ -11,6 +12,8 @@
 
 extern std::ofstream __log_file__;
 
+extern std::recursive_mutex __log_mutex__;
+
 struct Log_ {
 
     bool isSetTimestamp = true;
@@ -39,6 +42,8 @@ struct Log_ {
 
 private:
 
+    std::lock_guard<std::recursive_mutex> lock{__log_mutex__};
+
     template<typename T>
     void print(T t) {
         std::cout << t;
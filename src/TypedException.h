@@ -7,6 +7,7 @@ enum TypeErrors {
     DONT_CREATE_PUBLIC_KEY = 2,
     DONT_LOAD_PRIVATE_KEY = 3,
     DONT_SIGN = 4,
+    CANCELLED = 5,
     OTHER_ERROR = 1000
 };
 
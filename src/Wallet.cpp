@@ -19,8 +19,10 @@
 #include <cryptopp/ripemd.h>
 
 #include "openssl_wrapper/openssl_wrapper.h"
+#include "ethtx/scrypt/sha256.h"
 
 #include "check.h"
+#include "algorithms.h"
 #include "Log.h"
 #include "utils.h"
 #include "TypedException.h"
@@ -86,27 +88,18 @@ static void printPublicKey(const CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256
 }
 
 std::string Wallet::createAddress(const std::string &publicKeyBinary) {
-    CryptoPP::SHA256 sha256hashAlg;
-    std::string sha256Hash;
-    sha256Hash.reserve(500);
-    CryptoPP::StringSource ss1(publicKeyBinary, true, new CryptoPP::HashFilter(sha256hashAlg, new CryptoPP::StringSink(sha256Hash)));
+    uint8_t sha256Hash[SHA256_DIGEST_SIZE];
+    libscrypt_SHA256(publicKeyBinary.data(), publicKeyBinary.size(), sha256Hash);
 
     CryptoPP::RIPEMD160 ripemdHashAlg;
     std::string ripemdHash;
     ripemdHash.reserve(250);
-    CryptoPP::StringSource ss2(sha256Hash, true, new CryptoPP::HashFilter(ripemdHashAlg, new CryptoPP::StringSink(ripemdHash)));
+    CryptoPP::StringSource ss2(sha256Hash, sizeof(sha256Hash), true, new CryptoPP::HashFilter(ripemdHashAlg, new CryptoPP::StringSink(ripemdHash)));
     ripemdHash = '\0' + ripemdHash;
 
-    CryptoPP::SHA256 sha256hashAlg2;
-    std::string sha256Hash2;
-    sha256Hash2.reserve(500);
-    CryptoPP::StringSource ss3(ripemdHash, true, new CryptoPP::HashFilter(sha256hashAlg2, new CryptoPP::StringSink(sha256Hash2)));
-
-    CryptoPP::SHA256 sha256hashAlg3;
-    std::string sha256Hash3;
-    sha256Hash3.reserve(500);
-    CryptoPP::StringSource ss4(sha256Hash2, true, new CryptoPP::HashFilter(sha256hashAlg3, new CryptoPP::StringSink(sha256Hash3)));
-    ripemdHash += sha256Hash3.substr(0, 4);
+    uint8_t checksum[SHA256_DIGEST_SIZE];
+    libscrypt_SHA256d(ripemdHash.data(), ripemdHash.size(), checksum);
+    ripemdHash.append((const char*)checksum, 4);
 
     const std::string hexAddr = "0x" + toHex(ripemdHash);
 
@@ -161,15 +154,24 @@ std::vector<std::pair<QString, QString>> Wallet::getAllWalletsInFolder(const QSt
     const QDir dir(folder);
     const QStringList allFiles = dir.entryList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
     for (const QString &file: allFiles) {
-        if (file.endsWith(FILE_METAHASH_PRIV_KEY_SUFFIX)) {
-            const std::string address = file.split(FILE_METAHASH_PRIV_KEY_SUFFIX).first().toStdString();
-            result.emplace_back(QString::fromStdString(address), makeFullWalletPath(folder, address));
+        std::pair<QString, QString> wallet;
+        if (getWalletFromFile(folder, file, wallet)) {
+            result.emplace_back(wallet);
         }
     }
 
     return result;
 }
 
+bool Wallet::getWalletFromFile(const QString &folder, const QString &fileName, std::pair<QString, QString> &wallet) {
+    if (!fileName.endsWith(FILE_METAHASH_PRIV_KEY_SUFFIX)) {
+        return false;
+    }
+    const std::string address = fileName.split(FILE_METAHASH_PRIV_KEY_SUFFIX).first().toStdString();
+    wallet = std::make_pair(QString::fromStdString(address), makeFullWalletPath(folder, address));
+    return true;
+}
+
 Wallet::Wallet(const QString &folder, const std::string &name, const std::string &password)
     : folder(folder)
     , name(name)
@@ -192,6 +194,43 @@ Wallet::Wallet(const QString &folder, const std::string &name, const std::string
     }
 }
 
+Wallet::Wallet(const std::string &privateKeyBinary)
+    : Wallet(privateKeyBinary.data(), privateKeyBinary.size())
+{}
+
+Wallet::Wallet(const char *privateKeyBinary, size_t size) {
+    try {
+        const CryptoPP::Integer exponent((const byte*)privateKeyBinary, size);
+        privateKey.Initialize(CryptoPP::ASN1::secp256r1(), exponent);
+    } catch (const std::exception &e) {
+        throw TypedException(TypeErrors::DONT_LOAD_PRIVATE_KEY, std::string("Dont load private key. ") + e.what());
+    }
+}
+
+std::string Wallet::getPrivateKeyBinary() const {
+    const CryptoPP::Integer &exponent = privateKey.GetPrivateExponent();
+    std::string result(exponent.MinEncodedSize(), 0);
+    exponent.Encode((byte*)result.data(), result.size());
+    return result;
+}
+
+static std::string signMessage(const CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Signer &signer, CryptoPP::AutoSeededRandomPool &prng, const std::string &message) {
+    size_t siglen = signer.MaxSignatureLength();
+    std::string signature(siglen, 0x00);
+
+    siglen = signer.SignMessage(prng, (const byte*)message.data(), message.size(), (byte*)signature.data());
+    signature.resize(siglen);
+
+    std::string signature2(signature.size() * 10, 0);
+    const size_t resultSize = CryptoPP::DSAConvertSignatureFormat(
+        (byte*)signature2.data(), signature2.size(), CryptoPP::DSASignatureFormat::DSA_DER,
+        (const byte*)signature.data(), signature.size(), CryptoPP::DSASignatureFormat::DSA_P1363
+    );
+    signature2.resize(resultSize);
+
+    return toHex(signature2);
+}
+
 std::string Wallet::sign(const std::string &message, std::string &publicKey){
     try {
         printPublicKey(privateKey);
@@ -199,24 +238,38 @@ std::string Wallet::sign(const std::string &message, std::string &publicKey){
         CryptoPP::AutoSeededRandomPool prng;
         CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Signer signer(privateKey);
 
-        size_t siglen = signer.MaxSignatureLength();
-        std::string signature(siglen, 0x00);
+        const std::string signature = signMessage(signer, prng, message);
 
-        siglen = signer.SignMessage(prng, (const byte*)message.data(), message.size(), (byte*)signature.data());
-        signature.resize(siglen);
+        std::string pubKey;
+        getPublicKey(privateKey, pubKey);
+        publicKey = pubKey;
 
-        std::string signature2(signature.size() * 10, 0);
-        const size_t resultSize = CryptoPP::DSAConvertSignatureFormat(
-            (byte*)signature2.data(), signature2.size(), CryptoPP::DSASignatureFormat::DSA_DER,
-            (const byte*)signature.data(), signature.size(), CryptoPP::DSASignatureFormat::DSA_P1363
-        );
-        signature2.resize(resultSize);
+        return signature;
+    } catch (const std::exception &e) {
+        throw TypedException(TypeErrors::DONT_SIGN, std::string("dont sign ") + e.what());
+    }
+}
+
+std::vector<std::string> Wallet::sign(const std::vector<std::string> &messages, std::string &publicKey) {
+    try {
+        printPublicKey(privateKey);
+
+        std::vector<std::string> signatures(messages.size());
+        parallelFor(messages.size(), [this, &messages, &signatures](size_t begin, size_t end) {
+            // Объекты crypto++ не потокобезопасны, поэтому у каждого потока своя копия ключа
+            const CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey threadPrivateKey(privateKey);
+            CryptoPP::AutoSeededRandomPool prng;
+            CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Signer signer(threadPrivateKey);
+            for (size_t i = begin; i < end; i++) {
+                signatures[i] = signMessage(signer, prng, messages[i]);
+            }
+        });
 
         std::string pubKey;
         getPublicKey(privateKey, pubKey);
         publicKey = pubKey;
 
-        return toHex(signature2);
+        return signatures;
     } catch (const std::exception &e) {
         throw TypedException(TypeErrors::DONT_SIGN, std::string("dont sign ") + e.what());
     }
@@ -234,15 +287,28 @@ std::string Wallet::createRsaKey(const QString &folder, const std::string &addr,
 }
 
 std::string Wallet::decryptMessage(const QString &folder, const std::string &addr, const std::string &password, const std::string &encryptedMessageHex) {
+    const RsaKey rsaKey = readRsaKey(folder, addr, password);
+    const std::string decryptMsg = decrypt(rsaKey, encryptedMessageHex);
+    return decryptMsg;
+}
+
+RsaKey Wallet::readRsaKey(const QString &folder, const std::string &addr, const std::string &password) {
     CHECK(!folder.isNull() && !folder.isEmpty(), "Incorrect path to wallet: empty");
     const QString folderKey = QDir(folder).filePath(FOLDER_RSA_KEYS);
 
     const QString fileName = (QDir(folderKey).filePath(QString::fromStdString(addr).toLower() + FILE_PRIV_KEY_SUFFIX));
-    const std::string wifStr = readFile(fileName);
+    const std::string privateKey = readFile(fileName);
+    return ::readRsaKey(privateKey, password);
+}
 
-    const std::string privateKey = wifStr;
-    const std::string decryptMsg = decrypt(privateKey, password, encryptedMessageHex);
-    return decryptMsg;
+std::vector<std::string> Wallet::decryptMessages(const RsaKey &rsaKey, const std::vector<std::string> &encryptedMessagesHex) {
+    std::vector<std::string> messages(encryptedMessagesHex.size());
+    parallelFor(encryptedMessagesHex.size(), [&rsaKey, &encryptedMessagesHex, &messages](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            messages[i] = decrypt(rsaKey, encryptedMessagesHex[i]);
+        }
+    });
+    return messages;
 }
 
 std::string Wallet::encryptMessage(const std::string &publicKeyHex, const std::string &message) {
@@ -7,6 +7,8 @@
 
 #include <cryptopp/eccrypto.h>
 
+#include "openssl_wrapper/openssl_wrapper.h"
+
 class Wallet {
 public:
 
@@ -16,6 +18,8 @@ public:
 
     static std::vector<std::pair<QString, QString>> getAllWalletsInFolder(const QString &folder);
 
+    static bool getWalletFromFile(const QString &folder, const QString &fileName, std::pair<QString, QString> &wallet);
+
     /*
        Возвращает публичный ключ в base16
     */
@@ -23,14 +27,35 @@ public:
 
     static std::string decryptMessage(const QString &folder, const std::string &addr, const std::string &password, const std::string &encryptedMessageHex);
 
+    static RsaKey readRsaKey(const QString &folder, const std::string &addr, const std::string &password);
+
+    /*
+       Расшифровывает сообщения параллельно одним ключом
+    */
+    static std::vector<std::string> decryptMessages(const RsaKey &rsaKey, const std::vector<std::string> &encryptedMessagesHex);
+
     static std::string encryptMessage(const std::string &publicKeyHex, const std::string &message);
 
 public:
 
     Wallet(const QString &folder, const std::string &name, const std::string &password);
 
+    /*
+       Создает кошелек из уже расшифрованного ключа (см. getPrivateKeyBinary)
+    */
+    explicit Wallet(const std::string &privateKeyBinary);
+
+    Wallet(const char *privateKeyBinary, size_t size);
+
+    std::string getPrivateKeyBinary() const;
+
     std::string sign(const std::string &message, std::string &publicKey);
 
+    /*
+       Подписывает сообщения параллельно, расшифровывая ключ только один раз
+    */
+    std::vector<std::string> sign(const std::vector<std::string> &messages, std::string &publicKey);
+
     const QString& getFullPath() const {
         return fullPath;
     }
@@ -0,0 +1,165 @@
+#include "WalletsCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <cryptopp/osrng.h>
+#include <cryptopp/sha.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/misc.h>
+
+#include "check.h"
+#include "Log.h"
+
+const static size_t SALT_SIZE = 16;
+const static size_t PROCESS_SECRET_SIZE = 32;
+
+static std::string generateSalt() {
+    std::string salt(SALT_SIZE, 0);
+    CryptoPP::AutoSeededRandomPool prng;
+    prng.GenerateBlock((byte*)salt.data(), salt.size());
+    return salt;
+}
+
+static std::pair<std::string, std::string> makeKey(const std::string &folder, const std::string &address) {
+    std::string addressLower = address;
+    std::transform(addressLower.begin(), addressLower.end(), addressLower.begin(), ::tolower);
+    return std::make_pair(folder, addressLower);
+}
+
+static const LockedBuffer& processSecret() {
+    static const std::unique_ptr<LockedBuffer> secret = []() {
+        std::unique_ptr<LockedBuffer> result = std::make_unique<LockedBuffer>(PROCESS_SECRET_SIZE);
+        CryptoPP::AutoSeededRandomPool prng;
+        prng.GenerateBlock((byte*)result->data(), result->size());
+        return result;
+    }();
+    return *secret;
+}
+
+// Без секрета процесса проверка по дампу памяти не дает перебирать пароли
+static void passwordVerifier(const std::string &salt, const std::string &password, byte *verifier) {
+    const LockedBuffer &key = processSecret();
+    CryptoPP::HMAC<CryptoPP::SHA256> hmac((const byte*)key.data(), key.size());
+    hmac.Update((const byte*)salt.data(), salt.size());
+    hmac.Update((const byte*)password.data(), password.size());
+    hmac.Final(verifier);
+}
+
+static std::unique_ptr<LockedBuffer> makeVerifier(const std::string &salt, const std::string &password) {
+    std::unique_ptr<LockedBuffer> verifier = std::make_unique<LockedBuffer>(CryptoPP::SHA256::DIGESTSIZE);
+    passwordVerifier(salt, password, (byte*)verifier->data());
+    return verifier;
+}
+
+static bool checkVerifier(const LockedBuffer &verifier, const std::string &salt, const std::string &password) {
+    byte candidate[CryptoPP::SHA256::DIGESTSIZE];
+    passwordVerifier(salt, password, candidate);
+    const bool result = CryptoPP::VerifyBufsEqual(candidate, (const byte*)verifier.data(), sizeof(candidate));
+    CryptoPP::SecureWipeBuffer(candidate, sizeof(candidate));
+    return result;
+}
+
+void WalletsCache::unlock(const std::string &folder, const std::string &address, const std::string &password, const std::string &secret, seconds ttl) {
+    unlock(folder, address, password, secret.data(), secret.size(), ttl);
+}
+
+void WalletsCache::unlock(const std::string &folder, const std::string &address, const std::string &password, const char *secret, size_t secretSize, seconds ttl) {
+    Entry entry;
+    entry.salt = generateSalt();
+    entry.verifier = makeVerifier(entry.salt, password);
+    entry.secret = std::make_shared<const LockedBuffer>(secret, secretSize);
+    entry.expired = ::now() + ttl;
+
+    std::lock_guard<std::mutex> lock(mut);
+    entries[makeKey(folder, address)] = std::move(entry);
+}
+
+std::shared_ptr<const LockedBuffer> WalletsCache::find(const std::string &folder, const std::string &address, const std::string &password) {
+    std::lock_guard<std::mutex> lock(mut);
+    const auto found = entries.find(makeKey(folder, address));
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    const Entry &entry = found->second;
+    if (entry.expired <= ::now()) {
+        entries.erase(found);
+        return nullptr;
+    }
+    if (!checkVerifier(*entry.verifier, entry.salt, password)) {
+        return nullptr;
+    }
+    return entry.secret;
+}
+
+void WalletsCache::lock(const std::string &folder, const std::string &address) {
+    std::lock_guard<std::mutex> lock(mut);
+    entries.erase(makeKey(folder, address));
+}
+
+void WalletsCache::lockAll() {
+    std::lock_guard<std::mutex> lock(mut);
+    entries.clear();
+}
+
+void WalletsCache::removeExpired() {
+    const time_point currTime = ::now();
+    std::lock_guard<std::mutex> lock(mut);
+    for (auto iter = entries.begin(); iter != entries.end();) {
+        if (iter->second.expired <= currTime) {
+            iter = entries.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+void RsaKeysCache::add(const std::string &folder, const std::string &address, const std::string &password, const RsaKey &rsaKey, seconds ttl) {
+    Entry entry;
+    entry.salt = generateSalt();
+    entry.verifier = makeVerifier(entry.salt, password);
+    entry.rsaKey = rsaKey;
+    entry.expired = ::now() + ttl;
+
+    std::lock_guard<std::mutex> lock(mut);
+    entries[makeKey(folder, address)] = std::move(entry);
+}
+
+RsaKey RsaKeysCache::find(const std::string &folder, const std::string &address, const std::string &password) {
+    std::lock_guard<std::mutex> lock(mut);
+    const auto found = entries.find(makeKey(folder, address));
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    const Entry &entry = found->second;
+    if (entry.expired <= ::now()) {
+        entries.erase(found);
+        return nullptr;
+    }
+    if (!checkVerifier(*entry.verifier, entry.salt, password)) {
+        return nullptr;
+    }
+    return entry.rsaKey;
+}
+
+void RsaKeysCache::remove(const std::string &folder, const std::string &address) {
+    std::lock_guard<std::mutex> lock(mut);
+    entries.erase(makeKey(folder, address));
+}
+
+void RsaKeysCache::clear() {
+    std::lock_guard<std::mutex> lock(mut);
+    entries.clear();
+}
+
+void RsaKeysCache::removeExpired() {
+    const time_point currTime = ::now();
+    std::lock_guard<std::mutex> lock(mut);
+    for (auto iter = entries.begin(); iter != entries.end();) {
+        if (iter->second.expired <= currTime) {
+            iter = entries.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
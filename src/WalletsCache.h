@@ -0,0 +1,97 @@
+#ifndef WALLETSCACHE_H
+#define WALLETSCACHE_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "duration.h"
+#include "LockedBuffer.h"
+
+#include "openssl_wrapper/openssl_wrapper.h"
+
+/*
+   Кэш расшифрованных ключей кошельков. Кошелек попадает сюда только после явного unlock
+   и удаляется по истечении времени или по lock.
+   Ключ кэша - папка кошельков валюты и адрес.
+   Пароль проверяется по HMAC с секретом процесса, который, как и сам ключ, лежит в LockedBuffer.
+   */
+class WalletsCache {
+public:
+
+    void unlock(const std::string &folder, const std::string &address, const std::string &password, const std::string &secret, seconds ttl);
+
+    void unlock(const std::string &folder, const std::string &address, const std::string &password, const char *secret, size_t secretSize, seconds ttl);
+
+    /*
+       Возвращает nullptr, если кошелек не разблокирован, время истекло или пароль не совпадает.
+       Буфер остается живым, пока его держат, даже если кошелек тем временем заблокируют
+       */
+    std::shared_ptr<const LockedBuffer> find(const std::string &folder, const std::string &address, const std::string &password);
+
+    void lock(const std::string &folder, const std::string &address);
+
+    void lockAll();
+
+    void removeExpired();
+
+private:
+
+    struct Entry {
+        std::string salt;
+        std::unique_ptr<LockedBuffer> verifier;
+        std::shared_ptr<const LockedBuffer> secret;
+        time_point expired;
+    };
+
+    using Key = std::pair<std::string, std::string>;
+
+private:
+
+    std::map<Key, Entry> entries;
+
+    std::mutex mut;
+
+};
+
+/*
+   Кэш разобранных rsa ключей, чтобы пачка расшифровок не читала и не расшифровывала pem для каждого сообщения.
+   Ключ ищется по папке, адресу и паролю, запись живет ttl с момента добавления.
+   */
+class RsaKeysCache {
+public:
+
+    void add(const std::string &folder, const std::string &address, const std::string &password, const RsaKey &rsaKey, seconds ttl);
+
+    /*
+       Возвращает nullptr, если ключа нет, время истекло или пароль не совпадает
+       */
+    RsaKey find(const std::string &folder, const std::string &address, const std::string &password);
+
+    void remove(const std::string &folder, const std::string &address);
+
+    void clear();
+
+    void removeExpired();
+
+private:
+
+    struct Entry {
+        std::string salt;
+        std::unique_ptr<LockedBuffer> verifier;
+        RsaKey rsaKey;
+        time_point expired;
+    };
+
+    using Key = std::pair<std::string, std::string>;
+
+private:
+
+    std::map<Key, Entry> entries;
+
+    std::mutex mut;
+
+};
+
+#endif // WALLETSCACHE_H
@@ -0,0 +1,171 @@
+#include "WalletsIndex.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#include "check.h"
+#include "Log.h"
+
+static QString makeJsonWallets(const std::vector<std::pair<QString, QString>> &wallets) {
+    QJsonArray jsonArray;
+    for (const auto &r: wallets) {
+        jsonArray.push_back(r.first);
+    }
+    QJsonDocument json(jsonArray);
+    return json.toJson(QJsonDocument::Compact);
+}
+
+static QString makeJsonWalletsAndPaths(const std::vector<std::pair<QString, QString>> &wallets) {
+    QJsonArray jsonArray;
+    for (const auto &r: wallets) {
+        QJsonObject val;
+        val.insert("address", r.first);
+        val.insert("path", r.second);
+        jsonArray.push_back(val);
+    }
+    QJsonDocument json(jsonArray);
+    return json.toJson(QJsonDocument::Compact);
+}
+
+WalletsIndex::WalletsIndex(QObject *parent)
+    : QObject(parent)
+{
+    CHECK(connect(&watcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(onDirectoryChanged(const QString&))), "not connect directoryChanged");
+    CHECK(connect(&watcher, SIGNAL(fileChanged(const QString&)), this, SLOT(onFileChanged(const QString&))), "not connect fileChanged");
+}
+
+void WalletsIndex::addFolder(const QString &folder, const GetWalletFunction &getWallet) {
+    addFolderBatch(folder, [getWallet](const QString &folder, const std::vector<QString> &fileNames, std::vector<std::pair<QString, QString>> &wallets) {
+        wallets.assign(fileNames.size(), std::make_pair(QString(), QString()));
+        for (size_t i = 0; i < fileNames.size(); i++) {
+            if (!getWallet(folder, fileNames[i], wallets[i])) {
+                wallets[i] = std::make_pair(QString(), QString());
+            }
+        }
+    });
+}
+
+void WalletsIndex::addFolderBatch(const QString &folder, const GetWalletsFunction &getWallets) {
+    const QString path = QDir::cleanPath(folder);
+    std::lock_guard<std::mutex> lock(mut);
+    Folder &f = folders[path];
+    f.getWallets = getWallets;
+    f.files.clear();
+    f.isDirty = true;
+    if (!watcher.addPath(path)) {
+        LOG << "Warning: folder " << path << " not watched";
+    }
+}
+
+void WalletsIndex::clear() {
+    std::lock_guard<std::mutex> lock(mut);
+    folders.clear();
+    const QStringList directories = watcher.directories();
+    if (!directories.isEmpty()) {
+        watcher.removePaths(directories);
+    }
+    const QStringList files = watcher.files();
+    if (!files.isEmpty()) {
+        watcher.removePaths(files);
+    }
+}
+
+void WalletsIndex::invalidate(const QString &folder) {
+    std::lock_guard<std::mutex> lock(mut);
+    const auto found = folders.find(QDir::cleanPath(folder));
+    if (found != folders.end()) {
+        found->second.isDirty = true;
+    }
+}
+
+void WalletsIndex::invalidateAll() {
+    std::lock_guard<std::mutex> lock(mut);
+    for (auto &pair: folders) {
+        pair.second.isDirty = true;
+    }
+}
+
+void WalletsIndex::onDirectoryChanged(const QString &path) {
+    invalidate(path);
+}
+
+void WalletsIndex::onFileChanged(const QString &path) {
+    invalidate(QFileInfo(path).path());
+}
+
+WalletsIndex::Folder& WalletsIndex::rescan(const QString &folder) {
+    const auto found = folders.find(QDir::cleanPath(folder));
+    CHECK(found != folders.end(), "Folder " + folder.toStdString() + " not indexed");
+    Folder &f = found->second;
+    if (!f.isDirty) {
+        return f;
+    }
+
+    const QDir dir(folder);
+    const QFileInfoList allFiles = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
+
+    // Файл, перезаписанный на месте, разбирается заново
+    const auto isActual = [&f](const QFileInfo &info) {
+        const auto foundFile = f.files.find(info.fileName());
+        return foundFile != f.files.end() && foundFile->second.modified == info.lastModified() && foundFile->second.size == info.size();
+    };
+
+    std::vector<QString> newFiles;
+    for (const QFileInfo &info: allFiles) {
+        if (!isActual(info)) {
+            newFiles.emplace_back(info.fileName());
+        }
+    }
+    std::vector<std::pair<QString, QString>> newWallets;
+    if (!newFiles.empty()) {
+        f.getWallets(folder, newFiles, newWallets);
+    }
+    CHECK(newWallets.size() == newFiles.size(), "Incorrect wallets count in folder " + folder.toStdString());
+
+    std::map<QString, File> files;
+    std::vector<std::pair<QString, QString>> wallets;
+    QStringList newWalletPaths;
+    size_t newIndex = 0;
+    for (const QFileInfo &info: allFiles) {
+        File file;
+        file.modified = info.lastModified();
+        file.size = info.size();
+        if (isActual(info)) {
+            file.wallet = f.files.find(info.fileName())->second.wallet;
+        } else {
+            file.wallet = newWallets[newIndex++];
+            if (!file.wallet.first.isEmpty()) {
+                newWalletPaths.push_back(dir.filePath(info.fileName()));
+            }
+        }
+        if (!file.wallet.first.isEmpty()) {
+            wallets.emplace_back(file.wallet);
+        }
+        files.emplace(info.fileName(), file);
+    }
+
+    // Уже отслеживаемые пути watcher пропускает
+    if (!newWalletPaths.isEmpty()) {
+        watcher.addPaths(newWalletPaths);
+    }
+
+    f.files.swap(files);
+    f.walletsJson = makeJsonWallets(wallets);
+    f.walletsAndPathsJson = makeJsonWalletsAndPaths(wallets);
+    f.isDirty = false;
+    LOG << "Wallets folder " << folder << " rescanned. Wallets " << wallets.size();
+    return f;
+}
+
+QString WalletsIndex::getWalletsJson(const QString &folder) {
+    std::lock_guard<std::mutex> lock(mut);
+    return rescan(folder).walletsJson;
+}
+
+QString WalletsIndex::getWalletsAndPathsJson(const QString &folder) {
+    std::lock_guard<std::mutex> lock(mut);
+    return rescan(folder).walletsAndPathsJson;
+}
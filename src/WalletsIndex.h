@@ -0,0 +1,94 @@
+#ifndef WALLETSINDEX_H
+#define WALLETSINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QFileSystemWatcher>
+#include <QDateTime>
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/*
+   Индекс кошельков по папкам. Папка перечитывается только после изменения (QFileSystemWatcher или invalidate),
+   причем разбираются только новые файлы и файлы, у которых изменились время модификации или размер.
+   Файлы кошельков тоже отслеживаются, чтобы заметить перезапись на месте. Json с кошельками строится один раз на изменение.
+   */
+class WalletsIndex : public QObject {
+    Q_OBJECT
+public:
+
+    /*
+       Возвращает false, если файл не является кошельком
+       */
+    using GetWalletFunction = std::function<bool(const QString &folder, const QString &fileName, std::pair<QString, QString> &wallet)>;
+
+    /*
+       Разбирает сразу все новые файлы папки. wallets[i] - пустая пара, если fileNames[i] не кошелек
+       */
+    using GetWalletsFunction = std::function<void(const QString &folder, const std::vector<QString> &fileNames, std::vector<std::pair<QString, QString>> &wallets)>;
+
+public:
+
+    explicit WalletsIndex(QObject *parent = nullptr);
+
+    void addFolder(const QString &folder, const GetWalletFunction &getWallet);
+
+    void addFolderBatch(const QString &folder, const GetWalletsFunction &getWallets);
+
+    void clear();
+
+    void invalidate(const QString &folder);
+
+    void invalidateAll();
+
+    QString getWalletsJson(const QString &folder);
+
+    QString getWalletsAndPathsJson(const QString &folder);
+
+private slots:
+
+    void onDirectoryChanged(const QString &path);
+
+    void onFileChanged(const QString &path);
+
+private:
+
+    struct File {
+        QDateTime modified;
+
+        qint64 size = 0;
+
+        // Пустая пара, если файл не кошелек
+        std::pair<QString, QString> wallet;
+    };
+
+    struct Folder {
+        GetWalletsFunction getWallets;
+
+        std::map<QString, File> files;
+
+        QString walletsJson;
+
+        QString walletsAndPathsJson;
+
+        bool isDirty = true;
+    };
+
+private:
+
+    Folder& rescan(const QString &folder);
+
+private:
+
+    std::map<QString, Folder> folders;
+
+    QFileSystemWatcher watcher;
+
+    std::mutex mut;
+
+};
+
+#endif // WALLETSINDEX_H
@@ -4,6 +4,9 @@
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <thread>
+#include <future>
+#include <atomic>
 
 template<typename ReturnElement, typename Element, class ExtractInfo>
 std::vector<ReturnElement> getRandom(const std::vector<Element> &elements, size_t limit, size_t count, const ExtractInfo &extracter) {
@@ -27,4 +30,77 @@ Element getRandom(const std::vector<Element> &elements) {
     return ::getRandom<Element>(elements, elements.size(), 1, [](const auto &element) {return element;})[0];
 }
 
+/*
+   Общий на процесс запас дополнительных потоков для parallelFor: hardware_concurrency - 1.
+   Вложенные и одновременные вызовы (например, из нескольких потоков CryptoExecutor) делят его между собой,
+   а не запускают каждый по потоку на ядро. Взятые потоки возвращаются в деструкторе.
+   */
+class ParallelThreads {
+public:
+
+    explicit ParallelThreads(size_t wanted) {
+        std::atomic<size_t> &freeThreads = getFreeThreads();
+        size_t current = freeThreads.load();
+        do {
+            count = std::min(wanted, current);
+        } while (count != 0 && !freeThreads.compare_exchange_weak(current, current - count));
+    }
+
+    ~ParallelThreads() {
+        getFreeThreads() += count;
+    }
+
+    ParallelThreads(const ParallelThreads &) = delete;
+    ParallelThreads& operator=(const ParallelThreads &) = delete;
+
+    size_t size() const {
+        return count;
+    }
+
+private:
+
+    static std::atomic<size_t>& getFreeThreads() {
+        static std::atomic<size_t> freeThreads(std::max(size_t(std::thread::hardware_concurrency()), size_t(1)) - 1);
+        return freeThreads;
+    }
+
+private:
+
+    size_t count = 0;
+
+};
+
+/*
+   Делит отрезок [0, count) на части и обрабатывает их параллельно: текущий поток плюс столько потоков,
+   сколько удалось взять из ParallelThreads. Если свободных потоков нет, все выполняется в текущем потоке.
+   func(begin, end) вызывается по одному разу на каждую часть, одна из частей - в текущем потоке.
+   Исключение из любой части пробрасывается наружу.
+   */
+template<class Function>
+void parallelFor(size_t count, const Function &func) {
+    if (count == 0) {
+        return;
+    }
+    // Объявлен до futures, чтобы потоки вернулись в запас только после их завершения
+    const ParallelThreads helpers(count - 1);
+    const size_t countThreads = helpers.size() + 1;
+    if (countThreads <= 1) {
+        func(size_t(0), count);
+        return;
+    }
+
+    const size_t step = (count + countThreads - 1) / countThreads;
+    std::vector<std::future<void>> futures;
+    for (size_t begin = step; begin < count; begin += step) {
+        const size_t end = std::min(begin + step, count);
+        futures.emplace_back(std::async(std::launch::async, [&func, begin, end]() {
+            func(begin, end);
+        }));
+    }
+    func(size_t(0), step);
+    for (std::future<void> &future: futures) {
+        future.get();
+    }
+}
+
 #endif // ALGORITHMS_H
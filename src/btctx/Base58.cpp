@@ -2,46 +2,108 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <vector>
 
+#include "../ethtx/scrypt/sha256.h"
+
 static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+// Digit value of each character, -1 for characters outside the alphabet.
+static const int8_t mapBase58[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6,  7, 8,-1,-1,-1,-1,-1,-1,
+    -1, 9,10,11,12,13,14,15, 16,-1,17,18,19,20,21,-1,
+    22,23,24,25,26,27,28,29, 30,31,32,-1,-1,-1,-1,-1,
+    -1,33,34,35,36,37,38,39, 40,41,42,43,-1,44,45,46,
+    47,48,49,50,51,52,53,54, 55,56,57,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+// Instead of one digit per step the big numbers are kept in 32-bit limbs and
+// multiplied with 64-bit intermediates: base58 limbs hold 5 digits (58^5 < 2^30),
+// base256 limbs hold 4 bytes. Both directions then take (n/4)*(n/5) limb
+// operations instead of n*n byte operations. Wider limbs would need 128-bit
+// products, which MSVC does not have.
+static const int DIGITS_PER_LIMB = 5;
+static const uint32_t BASE58_LIMB = 58u * 58u * 58u * 58u * 58u;
+static const uint32_t POW58[DIGITS_PER_LIMB + 1] = {1, 58, 58 * 58, 58 * 58 * 58, 58 * 58 * 58 * 58, BASE58_LIMB};
+
+// Addresses, WIF keys and BIP38 keys fit here without touching the heap.
+static const size_t STACK_LIMBS = 32;
+
+// Apply "limbs = limbs * mul + carry" in base 2^32 or base 58^5. Returns the new number of limbs.
+template<uint64_t Base>
+static size_t mulAdd(uint32_t* limbs, size_t length, uint64_t mul, uint64_t carry)
+{
+    for (size_t i = 0; i < length; i++) {
+        carry += limbs[i] * mul;
+        limbs[i] = (uint32_t)(carry % Base);
+        carry /= Base;
+    }
+    while (carry != 0) {
+        limbs[length++] = (uint32_t)(carry % Base);
+        carry /= Base;
+    }
+    return length;
+}
+
 std::string EncodeBase58BTC(const unsigned char* pbegin, const unsigned char* pend)
 {
     // Skip & count leading zeroes.
-    int zeroes = 0;
-    int length = 0;
+    size_t zeroes = 0;
     while (pbegin != pend && *pbegin == 0) {
         pbegin++;
         zeroes++;
     }
-    // Allocate enough space in big-endian base58 representation.
-    int size = (pend - pbegin) * 138 / 100 + 1; // log(256) / log(58), rounded up.
-    std::vector<unsigned char> b58(size);
-    // Process the bytes.
+    const size_t bytes = pend - pbegin;
+    // Little-endian base 58^5 limbs. log(256) / log(58^5), rounded up.
+    const size_t maxLimbs = bytes * 138 / 500 + 2;
+    uint32_t stackLimbs[STACK_LIMBS];
+    std::vector<uint32_t> heapLimbs;
+    uint32_t* limbs = stackLimbs;
+    if (maxLimbs > STACK_LIMBS) {
+        heapLimbs.resize(maxLimbs);
+        limbs = heapLimbs.data();
+    }
+    size_t length = 0;
+    // Process the bytes four at a time, the leading remainder first.
+    size_t head = bytes % 4;
     while (pbegin != pend) {
-        int carry = *pbegin;
-        int i = 0;
-        // Apply "b58 = b58 * 256 + ch".
-        for (std::vector<unsigned char>::reverse_iterator it = b58.rbegin(); (carry != 0 || i < length) && (it != b58.rend()); it++, i++) {
-            carry += 256 * (*it);
-            *it = carry % 58;
-            carry /= 58;
+        const size_t take = head != 0 ? head : 4;
+        uint32_t word = 0;
+        for (size_t i = 0; i < take; i++) {
+            word = (word << 8) | *pbegin++;
+        }
+        length = mulAdd<BASE58_LIMB>(limbs, length, uint64_t(1) << (8 * take), word);
+        head = 0;
+    }
+    // The top limb is printed without its leading zeroes, the rest with all five digits.
+    size_t topDigits = 0;
+    if (length != 0) {
+        for (uint32_t top = limbs[length - 1]; top != 0; top /= 58) {
+            topDigits++;
+        }
+    }
+    std::string str(zeroes + (length == 0 ? 0 : topDigits + (length - 1) * DIGITS_PER_LIMB), '1');
+    size_t pos = str.size();
+    for (size_t i = 0; i < length; i++) {
+        uint32_t limb = limbs[i];
+        const size_t digits = (i + 1 == length) ? topDigits : DIGITS_PER_LIMB;
+        for (size_t d = 0; d < digits; d++) {
+            str[--pos] = pszBase58[limb % 58];
+            limb /= 58;
         }
-
-        //assert(carry == 0);
-        length = i;
-        pbegin++;
     }
-    // Skip leading zeroes in base58 result.
-    std::vector<unsigned char>::iterator it = b58.begin() + (size - length);
-    while (it != b58.end() && *it == 0)
-        it++;
-    // Translate the result into a string.
-    std::string str;
-    str.reserve(zeroes + (b58.end() - it));
-    str.assign(zeroes, '1');
-    while (it != b58.end())
-        str += pszBase58[*(it++)];
     return str;
 }
 
@@ -51,46 +113,91 @@ bool DecodeBase58(const char* psz, std::vector<unsigned char>& vch)
     while (*psz && isspace(*psz))
         psz++;
     // Skip and count leading '1's.
-    int zeroes = 0;
-    int length = 0;
+    size_t zeroes = 0;
     while (*psz == '1') {
         zeroes++;
         psz++;
     }
-    // Allocate enough space in big-endian base256 representation.
-    int size = strlen(psz) * 733 /1000 + 1; // log(58) / log(256), rounded up.
-    std::vector<unsigned char> b256(size);
-    // Process the characters.
-    while (*psz && !isspace(*psz)) {
-        // Decode base58 character
-        const char* ch = strchr(pszBase58, *psz);
-        if (ch == NULL)
-            return false;
-        // Apply "b256 = b256 * 58 + ch".
-        int carry = ch - pszBase58;
-        int i = 0;
-        for (std::vector<unsigned char>::reverse_iterator it = b256.rbegin(); (carry != 0 || i < length) && (it != b256.rend()); ++it, ++i) {
-            carry += 58 * (*it);
-            *it = carry % 256;
-            carry /= 256;
+    size_t digits = 0;
+    while (psz[digits] && !isspace(psz[digits]))
+        digits++;
+    // Little-endian base 2^32 limbs. log(58) / log(2^32), rounded up.
+    const size_t maxLimbs = digits * 733 / 4000 + 2;
+    uint32_t stackLimbs[STACK_LIMBS];
+    std::vector<uint32_t> heapLimbs;
+    uint32_t* limbs = stackLimbs;
+    if (maxLimbs > STACK_LIMBS) {
+        heapLimbs.resize(maxLimbs);
+        limbs = heapLimbs.data();
+    }
+    size_t length = 0;
+    // Process the characters five at a time, the leading remainder first.
+    size_t head = digits % DIGITS_PER_LIMB;
+    for (size_t i = 0; i < digits;) {
+        const size_t take = head != 0 ? head : DIGITS_PER_LIMB;
+        uint32_t value = 0;
+        for (size_t j = 0; j < take; j++, i++) {
+            // Decode base58 character
+            const int8_t digit = mapBase58[(uint8_t)psz[i]];
+            if (digit < 0)
+                return false;
+            value = value * 58 + digit;
         }
-        assert(carry == 0);
-        length = i;
-        psz++;
+        length = mulAdd<uint64_t(1) << 32>(limbs, length, POW58[take], value);
+        head = 0;
     }
+    psz += digits;
     // Skip trailing spaces.
     while (isspace(*psz))
         psz++;
     if (*psz != 0)
         return false;
-    // Skip leading zeroes in b256.
-    std::vector<unsigned char>::iterator it = b256.begin() + (size - length);
-    while (it != b256.end() && *it == 0)
-        it++;
-    // Copy result into output vector.
-    vch.reserve(zeroes + (b256.end() - it));
-    vch.assign(zeroes, 0x00);
-    while (it != b256.end())
-        vch.push_back(*(it++));
+    // Copy result into output vector, without leading zeroes of the top limb.
+    size_t topBytes = 0;
+    if (length != 0) {
+        for (uint32_t top = limbs[length - 1]; top != 0; top >>= 8) {
+            topBytes++;
+        }
+    }
+    vch.assign(zeroes + (length == 0 ? 0 : topBytes + (length - 1) * 4), 0x00);
+    size_t pos = vch.size();
+    for (size_t i = 0; i < length; i++) {
+        uint32_t limb = limbs[i];
+        const size_t bytes = (i + 1 == length) ? topBytes : 4;
+        for (size_t b = 0; b < bytes; b++) {
+            vch[--pos] = (unsigned char)limb;
+            limb >>= 8;
+        }
+    }
     return true;
 }
+
+std::vector<bool> validateAddresses(const std::vector<std::string>& addresses)
+{
+    const size_t ADDRESS_SIZE = 25;
+    const size_t PAYLOAD_SIZE = ADDRESS_SIZE - 4;
+    std::vector<bool> result(addresses.size(), false);
+    std::vector<unsigned char> payloads(addresses.size() * ADDRESS_SIZE);
+    std::vector<const unsigned char*> in;
+    std::vector<size_t> lens;
+    std::vector<size_t> indexes;
+    in.reserve(addresses.size());
+    indexes.reserve(addresses.size());
+    std::vector<unsigned char> decoded;
+    for (size_t i = 0; i < addresses.size(); i++) {
+        if (!DecodeBase58(addresses[i].c_str(), decoded) || decoded.size() != ADDRESS_SIZE) {
+            continue;
+        }
+        unsigned char* payload = payloads.data() + indexes.size() * ADDRESS_SIZE;
+        memcpy(payload, decoded.data(), ADDRESS_SIZE);
+        in.push_back(payload);
+        indexes.push_back(i);
+    }
+    lens.assign(in.size(), PAYLOAD_SIZE);
+    std::vector<unsigned char> hashes(in.size() * SHA256_DIGEST_SIZE);
+    libscrypt_SHA256d_batch(in.data(), lens.data(), in.size(), (unsigned char (*)[SHA256_DIGEST_SIZE])hashes.data());
+    for (size_t i = 0; i < indexes.size(); i++) {
+        result[indexes[i]] = memcmp(in[i] + PAYLOAD_SIZE, hashes.data() + i * SHA256_DIGEST_SIZE, 4) == 0;
+    }
+    return result;
+}
@@ -9,4 +9,8 @@
 std::string EncodeBase58BTC(const unsigned char* pbegin, const unsigned char* pend);
 bool DecodeBase58(const char* psz, std::vector<unsigned char>& vch);
 
+// Checks that every string is a 25-byte Base58Check address with a correct checksum.
+// The checksums of the whole list are computed in one batch.
+std::vector<bool> validateAddresses(const std::vector<std::string>& addresses);
+
 #endif
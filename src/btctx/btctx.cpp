@@ -1,18 +1,33 @@
 #include "btctx.h"
 
 #include <algorithm>
-#include "cryptopp/sha.h"
 #include "secp256k1/include/secp256k1_recovery.h"
 
 #include <iostream>
 
+#include <cryptopp/misc.h>
+
 #include "check.h"
 
 #include "wif.h"
 #include "ethtx/utils2.h"
 #include "ethtx/const.h"
+#include "ethtx/scrypt/sha256.h"
+#include "ethtx/secp256k1ctx.h"
+
+static void wipeString(std::string &str) {
+    if (!str.empty()) {
+        CryptoPP::SecureWipeBuffer((byte*)&str[0], str.size());
+    }
+}
 
-secp256k1_context const* getCtx();
+Input::~Input() {
+    wipeString(wif);
+}
+
+TransferInfo::~TransferInfo() {
+    wipeString(privkey);
+}
 
 void BTCTransaction::AddTransfer(
     const std::string& wif,
@@ -52,13 +67,9 @@ std::string BTCTransaction::BuildTransaction(uint64_t fee, uint64_t transferAmou
 
 std::string BTCTransaction::doubleHash(const std::string& str) {
     //2 раза подсчитываем sha256-хэш от строки
-    CryptoPP::SHA256 sha256;
-    uint8_t sha256hash[CryptoPP::SHA256::DIGESTSIZE] = {0};
-    sha256.CalculateDigest(sha256hash, (uint8_t*)str.data(), str.size());
-    //Подсчитываем хэш от хеша
-    uint8_t sha256hashfinal[CryptoPP::SHA256::DIGESTSIZE] = {0};
-    sha256.CalculateDigest(sha256hashfinal, sha256hash, CryptoPP::SHA256::DIGESTSIZE);
-    return std::string((char*)sha256hashfinal, CryptoPP::SHA256::DIGESTSIZE);
+    uint8_t sha256hashfinal[SHA256_DIGEST_SIZE] = {0};
+    libscrypt_SHA256d(str.data(), str.size(), sha256hashfinal);
+    return std::string((char*)sha256hashfinal, SHA256_DIGEST_SIZE);
 }
 
 std::string BTCTransaction::removeScripts(const std::string& signingdump, size_t scriptIdx, const std::vector<TransferInfo>& ti) {
@@ -11,6 +11,9 @@ struct Input
     uint32_t spendoutnum;
     std::string scriptPubkey;
     uint64_t outBalance;
+
+    // Затирает wif
+    ~Input();
 };
 
 std::string BuildBTCTransaction(const std::vector<Input>& inputs, uint64_t fee,
@@ -27,6 +30,9 @@ struct TransferInfo
     std::string receiveAddress;
     size_t inscriptoffset;//Полный размер т.е. вместе с полем размера
     size_t inscriptsize;
+
+    // Затирает privkey
+    ~TransferInfo();
 };
 
 class BTCTransaction
@@ -4,15 +4,18 @@
 #include <algorithm>
 #include <iostream>
 #include <array>
+#include <cerrno>
 
 #include "cryptopp/oids.h"
 #include "cryptopp/osrng.h"
 #include "cryptopp/ripemd.h"
 #include <cryptopp/ccm.h>
+#include <cryptopp/misc.h>
 
 #include "secp256k1/include/secp256k1_recovery.h"
 
 #include "../ethtx/scrypt/libscrypt.h"
+#include "../ethtx/scrypt/sha256.h"
 
 #include "check.h"
 
@@ -20,8 +23,7 @@
 #include "ethtx/cert.h"
 #include "ethtx/const.h"
 #include "ethtx/utils2.h"
-
-secp256k1_context const* getCtx();
+#include "ethtx/secp256k1ctx.h"
 
 std::string WIFToPrivkey(const std::string& wif, bool& isCompressed) {
     std::vector<unsigned char> decoded;
@@ -30,6 +32,7 @@ std::string WIFToPrivkey(const std::string& wif, bool& isCompressed) {
     isCompressed = (decoded.size() == 38 && decoded[33] == 0x1);
     CHECK(decoded.size() >= 33, "dont decode wif key");
     const std::string rawprivkey = std::string((char*)decoded.data() + 1, 32);
+    CryptoPP::SecureWipeBuffer(decoded.data(), decoded.size());
     return rawprivkey;
 }
 
@@ -56,12 +59,9 @@ std::string PrivKeyToCompressedPubKey(const std::string& rawprivkey) {
 }
 
 static std::string doubleHash(const std::string &str) {
-    uint8_t firsthash[CryptoPP::SHA256::DIGESTSIZE] = {0};
-    uint8_t secondhash[CryptoPP::SHA256::DIGESTSIZE] = {0};
-    CryptoPP::SHA256 sha256;
-    sha256.CalculateDigest(firsthash, (const uint8_t*)str.data(), str.size());
-    sha256.CalculateDigest(secondhash, firsthash, CryptoPP::SHA256::DIGESTSIZE);
-    return std::string((const char*)secondhash, CryptoPP::SHA256::DIGESTSIZE);
+    uint8_t hash[SHA256_DIGEST_SIZE] = {0};
+    libscrypt_SHA256d(str.data(), str.size(), hash);
+    return std::string((const char*)hash, SHA256_DIGEST_SIZE);
 }
 
 std::string PubkeyToAddress(const std::string& rawpubkey, bool testnet) {
@@ -70,10 +70,9 @@ std::string PubkeyToAddress(const std::string& rawpubkey, bool testnet) {
     uint8_t address[ADDRESS_LENGTH] = {0};
     uint8_t* pk = (uint8_t*)rawpubkey.data();
     CHECK(pk[0] == 0x04, "incorrect pub key");
-    CryptoPP::SHA256 sha256;
-    uint8_t sha256hash[CryptoPP::SHA256::DIGESTSIZE] = {0};
+    uint8_t sha256hash[SHA256_DIGEST_SIZE] = {0};
     //Подсчитываем первый sha256-хэш.
-    sha256.CalculateDigest(sha256hash, pk, EC_PUB_KEY_LENGTH);
+    libscrypt_SHA256(pk, EC_PUB_KEY_LENGTH, sha256hash);
     //Сетевой байт
     if (testnet) {
         address[0] = 0x6F;
@@ -83,7 +82,7 @@ std::string PubkeyToAddress(const std::string& rawpubkey, bool testnet) {
     //RIPEMD160-хэш от предыдущего
     CHECK(ADDRESS_LENGTH >= CryptoPP::RIPEMD160::DIGESTSIZE + 1, "Ups");
     CryptoPP::RIPEMD160 ripemd;
-    ripemd.CalculateDigest(&address[1], sha256hash, CryptoPP::SHA256::DIGESTSIZE);
+    ripemd.CalculateDigest(&address[1], sha256hash, SHA256_DIGEST_SIZE);
     const std::string finalhash = doubleHash(std::string((const char*)address, CryptoPP::RIPEMD160::DIGESTSIZE + 1));
     address[21] = finalhash[0];
     address[22] = finalhash[1];
@@ -99,10 +98,9 @@ std::string CompressedPubkeyToAddress(const std::string& rawpubkey, bool testnet
     uint8_t address[ADDRESS_LENGTH] = {0};
     uint8_t* pk = (uint8_t*)rawpubkey.data();
     CHECK(pk[0] == 0x03 || pk[0] == 0x02, "Incorrect pub key");
-    CryptoPP::SHA256 sha256;
-    uint8_t sha256hash[CryptoPP::SHA256::DIGESTSIZE] = {0};
+    uint8_t sha256hash[SHA256_DIGEST_SIZE] = {0};
     //Подсчитываем первый sha256-хэш.
-    sha256.CalculateDigest(sha256hash, pk, EC_KEY_LENGTH+1);
+    libscrypt_SHA256(pk, EC_KEY_LENGTH+1, sha256hash);
     //Сетевой байт
     if (testnet) {
         address[0] = 0x6F;
@@ -112,7 +110,7 @@ std::string CompressedPubkeyToAddress(const std::string& rawpubkey, bool testnet
     //RIPEMD160-хэш от предыдущего
     CHECK(ADDRESS_LENGTH >= CryptoPP::RIPEMD160::DIGESTSIZE + 1, "Ups");
     CryptoPP::RIPEMD160 ripemd;
-    ripemd.CalculateDigest(&address[1], sha256hash, CryptoPP::SHA256::DIGESTSIZE);
+    ripemd.CalculateDigest(&address[1], sha256hash, SHA256_DIGEST_SIZE);
     //Сохраняем чек-сумму
     const std::string finalhash = doubleHash(std::string((const char*)address, CryptoPP::RIPEMD160::DIGESTSIZE + 1));
     address[21] = finalhash[0];
@@ -197,7 +195,7 @@ std::string getAddress(const std::string &wif, bool &isCompressed, bool isTestne
     return addressBase58;
 }
 
-std::string encryptWif(const std::string &wif, const std::string &normalizedPassphraze) {
+std::string encryptWif(const std::string &wif, const std::string &normalizedPassphraze, const ScryptParams &kdfParams) {
     bool isCompressed;
     const std::string addressBase58 = getAddress(wif, isCompressed, false);
     const std::string privKey = WIFToPrivkey(wif, isCompressed);
@@ -210,17 +208,15 @@ std::string encryptWif(const std::string &wif, const std::string &normalizedPass
 
     const std::string checksumAddress = doubleHash(addressBase58);
     const std::string salt = checksumAddress.substr(0, 4);
-    const int n=16384;
-    const int r=8;
-    const int p=8;
     std::array<uint8_t, 64> derivedkey;
 
-    libscrypt_scrypt(
+    const int resultScrypt = libscrypt_scrypt(
         (const uint8_t*)normalizedPassphraze.c_str(), normalizedPassphraze.size(),
         (const uint8_t*)salt.data(), salt.size(),
-        n, r, p,
+        kdfParams.n, kdfParams.r, kdfParams.p,
         derivedkey.data(), derivedkey.size()
     );
+    CHECK(resultScrypt == 0, "scrypt error " + std::to_string(errno));
     const std::string derivedHalfStr1(derivedkey.begin(), derivedkey.begin() + derivedkey.size() / 2);
     const std::string derivedHalfStr2(derivedkey.begin() + derivedkey.size() / 2, derivedkey.end());
 
@@ -257,7 +253,7 @@ std::string encryptWif(const std::string &wif, const std::string &normalizedPass
     return EncodeBase58BTC((const unsigned char*)result.data(), (const unsigned char*)result.data() + result.size());
 }
 
-std::string decryptWif(const std::string &encryptedWifBase64, const std::string &normalizedPassphraze) {
+std::string decryptWif(const std::string &encryptedWifBase64, const std::string &normalizedPassphraze, const ScryptParams &kdfParams) {
     CHECK(encryptedWifBase64.size() == 58, "Incorrect encripted wif size " + std::to_string(encryptedWifBase64.size()));
     std::vector<unsigned char> encryptedWifVect;
     const bool res = DecodeBase58(encryptedWifBase64.c_str(), encryptedWifVect);
@@ -275,17 +271,15 @@ std::string decryptWif(const std::string &encryptedWifBase64, const std::string
     const std::string checksum = encryptedWif.substr(39);
     CHECK(checksum == doubleHash(encryptedWif.substr(0, 39)).substr(0, 4), "Incorrect encrypted wif");
 
-    const int n=16384;
-    const int r=8;
-    const int p=8;
     std::array<uint8_t, 64> derivedkey;
 
-    libscrypt_scrypt(
+    const int resultScrypt = libscrypt_scrypt(
         (const uint8_t*)normalizedPassphraze.c_str(), normalizedPassphraze.size(),
         (const uint8_t*)salt.data(), salt.size(),
-        n, r, p,
+        kdfParams.n, kdfParams.r, kdfParams.p,
         derivedkey.data(), derivedkey.size()
     );
+    CHECK(resultScrypt == 0, "scrypt error " + std::to_string(errno));
     const std::string derivedHalfStr1(derivedkey.begin(), derivedkey.begin() + derivedkey.size() / 2);
     const std::string derivedHalfStr2(derivedkey.begin() + derivedkey.size() / 2, derivedkey.end());
 
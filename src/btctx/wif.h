@@ -3,6 +3,8 @@
 
 #include <string>
 
+#include "KdfProfiles.h"
+
 std::string WIFToPrivkey(const std::string& wif, bool& isCompressed);
 std::string PrivKeyToPubKey(const std::string& rawprivkey);
 std::string PubkeyToAddress(const std::string& rawpubkey, bool testnet);
@@ -15,7 +17,7 @@ void checkAddressBase56(const std::string &address);
 
 std::string getAddress(const std::string &wif, bool &isCompressed, bool isTestnet);
 
-std::string encryptWif(const std::string &wif, const std::string &normalizedPassphraze);
-std::string decryptWif(const std::string &encryptedWif, const std::string &normalizedPassphraze);
+std::string encryptWif(const std::string &wif, const std::string &normalizedPassphraze, const ScryptParams &kdfParams = BIP38_SCRYPT_PARAMS);
+std::string decryptWif(const std::string &encryptedWif, const std::string &normalizedPassphraze, const ScryptParams &kdfParams = BIP38_SCRYPT_PARAMS);
 
 #endif // WIF_H_
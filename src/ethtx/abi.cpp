@@ -0,0 +1,80 @@
+#include "abi.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "keccak.h"
+#include "hex.h"
+
+#include "check.h"
+
+const static size_t ADDRESS_SIZE = 20;
+
+void AbiSelector(const std::string &signature, uint8_t* selector) {
+    uint8_t hash[KECCAK256_HASH_LENGTH];
+    Keccak256((const uint8_t*)signature.data(), signature.size(), hash);
+    memcpy(selector, hash, ABI_SELECTOR_SIZE);
+}
+
+void AbiEncodeAddress(const std::string &address, uint8_t* slot) {
+    CHECK(address.size() == 2 + 2 * ADDRESS_SIZE && address.compare(0, 2, "0x") == 0, "Incorrect address " + address);
+    memset(slot, 0, ABI_SLOT_SIZE - ADDRESS_SIZE);
+    CHECK(HexDecode(address.data() + 2, 2 * ADDRESS_SIZE, slot + ABI_SLOT_SIZE - ADDRESS_SIZE), "Incorrect address " + address);
+}
+
+void AbiEncodeUint256(const std::string &value, uint8_t* slot) {
+    memset(slot, 0, ABI_SLOT_SIZE);
+    if (value.compare(0, 2, "0x") == 0) {
+        const size_t begin = std::min(value.find_first_not_of('0', 2), value.size());
+        const size_t hexSize = value.size() - begin;
+        CHECK(value.size() > 2 && HexDecodedSize(hexSize) <= ABI_SLOT_SIZE, "Incorrect uint256 " + value);
+        CHECK(HexDecode(value.data() + begin, hexSize, slot + ABI_SLOT_SIZE - HexDecodedSize(hexSize)), "Incorrect uint256 " + value);
+        return;
+    }
+
+    CHECK(!value.empty(), "Incorrect uint256 " + value);
+    for (const char c: value) {
+        CHECK(c >= '0' && c <= '9', "Incorrect uint256 " + value);
+        //slot = slot * 10 + digit
+        unsigned int carry = c - '0';
+        for (size_t i = ABI_SLOT_SIZE; i > 0; i--) {
+            carry += slot[i - 1] * 10U;
+            slot[i - 1] = (uint8_t)carry;
+            carry >>= 8;
+        }
+        CHECK(carry == 0, "uint256 overflow " + value);
+    }
+}
+
+AbiEncoder::AbiEncoder(const std::string &signature)
+    : data(ABI_SELECTOR_SIZE)
+{
+    AbiSelector(signature, data.data());
+}
+
+uint8_t* AbiEncoder::nextSlot() {
+    data.resize(data.size() + ABI_SLOT_SIZE);
+    return data.data() + data.size() - ABI_SLOT_SIZE;
+}
+
+AbiEncoder& AbiEncoder::address(const std::string &address) {
+    AbiEncodeAddress(address, nextSlot());
+    return *this;
+}
+
+AbiEncoder& AbiEncoder::uint256(const std::string &value) {
+    AbiEncodeUint256(value, nextSlot());
+    return *this;
+}
+
+std::string AbiEncoder::toHex() const {
+    std::string result(2 + HexEncodedSize(data.size()), '\0');
+    result[0] = '0';
+    result[1] = 'x';
+    HexEncode(data.data(), data.size(), &result[2]);
+    return result;
+}
+
+std::string Erc20TransferData(const std::string &to, const std::string &amount) {
+    return AbiEncoder("transfer(address,uint256)").address(to).uint256(amount).toHex();
+}
@@ -0,0 +1,49 @@
+#ifndef ETHTX_ABI
+#define ETHTX_ABI
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+const size_t ABI_SELECTOR_SIZE = 4;
+const size_t ABI_SLOT_SIZE = 32;
+
+//Первые 4 байта Keccak256 от канонической сигнатуры, например "transfer(address,uint256)"
+void AbiSelector(const std::string &signature, uint8_t* selector);
+
+//Адрес 0x и 40 hex символов, дополняется нулями слева до 32 байт
+void AbiEncodeAddress(const std::string &address, uint8_t* slot);
+
+//Число big-endian в 32 байтах. Принимает 16ричную строку с 0x или десятичную.
+//Не помещающееся в 256 бит число - ошибка
+void AbiEncodeUint256(const std::string &value, uint8_t* slot);
+
+//Данные вызова функции со статическими аргументами: селектор и по слоту на аргумент.
+//Динамические типы (bytes, string, массивы) не поддерживаются
+class AbiEncoder {
+public:
+
+    explicit AbiEncoder(const std::string &signature);
+
+    AbiEncoder& address(const std::string &address);
+
+    AbiEncoder& uint256(const std::string &value);
+
+    //16ричная строка с 0x, готовая для поля data транзакции
+    std::string toHex() const;
+
+private:
+
+    uint8_t* nextSlot();
+
+private:
+
+    std::vector<uint8_t> data;
+};
+
+//transfer(address,uint256) из ERC-20
+std::string Erc20TransferData(const std::string &to, const std::string &amount);
+
+#endif
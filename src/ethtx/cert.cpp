@@ -1,15 +1,16 @@
 #include "cert.h"
 #include "utils2.h"
 #include "const.h"
+#include "keccak.h"
 
 #include "scrypt/libscrypt.h"
 
 #include <cryptopp/oids.h>
-#include <cryptopp/keccak.h>
 #include <cryptopp/aes.h>
 #include <cryptopp/ccm.h>
 
 #include <iostream>
+#include <cerrno>
 
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -67,10 +68,11 @@ std::string DeriveAESKeyFromPassword(const std::string& password, CertParams& pa
 {
     uint8_t derivedKey[EC_KEY_LENGTH] = {0};
     std::string rawsalt = HexStringToDump(params.salt);
-    libscrypt_scrypt((const uint8_t*)password.c_str(), password.size(),
+    const int resultScrypt = libscrypt_scrypt((const uint8_t*)password.c_str(), password.size(),
                         (const uint8_t*)rawsalt.c_str(), rawsalt.size(),
                         params.n, params.r, params.p,
                         derivedKey, EC_KEY_LENGTH);
+    CHECK(resultScrypt == 0, "scrypt error " + std::to_string(errno));
     return std::string((char*)derivedKey, EC_KEY_LENGTH);
 }
 
@@ -79,9 +81,7 @@ bool CheckPassword(const std::string& derivedKey, const CertParams& params)
     uint8_t hs[EC_KEY_LENGTH];
     CHECK(derivedKey.size() >= 32, "Incorrect derivedKey");
     std::string hashdata = derivedKey.substr(16, 16) + HexStringToDump(params.ciphertext);
-    CryptoPP::Keccak k(EC_KEY_LENGTH);
-    k.Update((uint8_t*)hashdata.c_str(), hashdata.size());
-    k.TruncatedFinal(hs, EC_KEY_LENGTH);
+    Keccak256((const uint8_t*)hashdata.data(), hashdata.size(), hs);
     return (params.mac.compare(DumpToHexString(hs, EC_KEY_LENGTH)) == 0);
 }
 
@@ -1,8 +1,13 @@
 #ifndef ETHTX_SIGN
 #define ETHTX_SIGN
 
+#include <string>
+#include <vector>
+
 #include <cryptopp/eccrypto.h>
 
+#include "KdfProfiles.h"
+
 struct CertParams
 {
     int version;
@@ -22,9 +27,14 @@ struct CertParams
 };
 
 CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey DecodeCert(const char* certContent, std::string& pass, uint8_t* rawkey);
-std::pair<std::string, std::string> CreateNewKey(const std::string& password);
+//Параметры scrypt записываются в kdfparams файла ключа
+std::pair<std::string, std::string> CreateNewKey(const std::string& password, const ScryptParams& kdfParams);
 std::string AddressFromPrivateKey(const std::string& privkey);
 std::string DeriveAESKeyFromPassword(const std::string& password, CertParams& params);
 std::string MixedCaseEncoding(const std::string& binaryAddress);
+std::vector<std::string> MixedCaseEncoding(const std::vector<std::string>& binaryAddresses);
+//Проверка контрольной суммы EIP-55 адресов вида 0x + 40 hex символов.
+//Адрес целиком в одном регистре контрольной суммы не содержит и считается верным
+std::vector<bool> CheckMixedCaseAddresses(const std::vector<std::string>& addresses);
 
 #endif
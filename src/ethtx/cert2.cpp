@@ -3,24 +3,25 @@
 #include <stdlib.h>
 
 #include <iostream>
+#include <cerrno>
 
 #include <secp256k1/include/secp256k1_recovery.h>
 
 #include <cryptopp/oids.h>
 #include <cryptopp/osrng.h>
-#include <cryptopp/keccak.h>
 #include <cryptopp/ccm.h>
 
 #include "crossguid/Guid.hpp"
 
 #include "utils2.h"
 #include "const.h"
+#include "keccak.h"
 
 #include "scrypt/libscrypt.h"
 
-#include "check.h"
+#include "secp256k1ctx.h"
 
-secp256k1_context const* getCtx();
+#include "check.h"
 
 #ifdef _WIN32
 int libscrypt_salt_gen(uint8_t *salt, size_t len);
@@ -28,57 +29,107 @@ int libscrypt_salt_gen(uint8_t *salt, size_t len);
 extern "C" int libscrypt_salt_gen(uint8_t *salt, size_t len);
 #endif
 
+//Переводит в верхний регистр те буквы адреса, для которых соответствующий полубайт keccak256 >= 8
+static void applyMixedCase(std::string& hexaddress, const uint8_t* hs)
+{
+    CHECK(hexaddress.size() <= 2 * KECCAK256_HASH_LENGTH, "Ups");
+    for (size_t i = 0; i < hexaddress.size(); i++)
+    {
+        const uint8_t nibble = (i % 2 == 0) ? (hs[i / 2] >> 4) : (hs[i / 2] & 0xf);
+        if (nibble >= 8)
+            hexaddress[i] = toupper(hexaddress[i]);
+    }
+}
+
 //Кодирование адреса ethereum
 std::string MixedCaseEncoding(const std::string& binaryAddress)
 {
     //Берем 16-ричное представление адреса
     std::string hexaddress = DumpToHexString(binaryAddress);
     //Находим keccak256 от него
-    uint8_t hs[EC_KEY_LENGTH];
-    CryptoPP::Keccak k(EC_KEY_LENGTH);
-    k.Update((uint8_t*)hexaddress.c_str(), hexaddress.size());
-    k.TruncatedFinal(hs, EC_KEY_LENGTH);
-    //Переводим хэш в 16-ричное представление
-    std::string hexhs = DumpToHexString(hs, EC_KEY_LENGTH);
+    uint8_t hs[KECCAK256_HASH_LENGTH];
+    Keccak256((const uint8_t*)hexaddress.data(), hexaddress.size(), hs);
     //Преобразуем исходный адрес в соответсвии с значением keccak256
-    char a = 0;
-    std::string normalizedAddr = "";
-    CHECK(hexhs.size() >= hexaddress.size(), "Ups");
-    for (size_t i = 0; i < hexaddress.size(); i++)
+    applyMixedCase(hexaddress, hs);
+    return hexaddress;
+}
+
+std::vector<std::string> MixedCaseEncoding(const std::vector<std::string>& binaryAddresses)
+{
+    std::vector<std::string> hexaddresses;
+    hexaddresses.reserve(binaryAddresses.size());
+    for (const std::string& binaryAddress: binaryAddresses)
+        hexaddresses.emplace_back(DumpToHexString(binaryAddress));
+    const std::vector<Keccak256Hash> hashes = Keccak256Batch(hexaddresses);
+    for (size_t i = 0; i < hexaddresses.size(); i++)
+        applyMixedCase(hexaddresses[i], hashes[i].data());
+    return hexaddresses;
+}
+
+std::vector<bool> CheckMixedCaseAddresses(const std::vector<std::string>& addresses)
+{
+    std::vector<bool> result(addresses.size(), false);
+    //Адреса, в которых есть буквы обоих регистров, и их запись в нижнем регистре
+    std::vector<size_t> indexes;
+    std::vector<std::string> lowerAddresses;
+    for (size_t i = 0; i < addresses.size(); i++)
     {
-        a = hexhs.at(i);
-        if (a >= '0' && a <= '9')
-            a = a - '0';
-        else
+        const std::string& address = addresses[i];
+        if (address.size() != 42 || address.compare(0, 2, "0x") != 0)
+            continue;
+        bool isHex = true;
+        bool hasLower = false;
+        bool hasUpper = false;
+        std::string lower = address.substr(2);
+        for (char& c: lower)
         {
-            if (a >= 'a' && a <= 'f')
-                a = a - 'a' + 10;
+            if (c >= 'a' && c <= 'f') {
+                hasLower = true;
+            } else if (c >= 'A' && c <= 'F') {
+                hasUpper = true;
+                c = c - 'A' + 'a';
+            } else if (c < '0' || c > '9') {
+                isHex = false;
+            }
         }
-        if (a >= 8)
-            normalizedAddr += toupper(hexaddress.at(i));
-        else
-            normalizedAddr += hexaddress.at(i);
+        if (!isHex)
+            continue;
+        if (!hasLower || !hasUpper)
+        {
+            result[i] = true;
+            continue;
+        }
+        indexes.push_back(i);
+        lowerAddresses.emplace_back(std::move(lower));
+    }
+
+    const std::vector<Keccak256Hash> hashes = Keccak256Batch(lowerAddresses);
+    for (size_t j = 0; j < indexes.size(); j++)
+    {
+        applyMixedCase(lowerAddresses[j], hashes[j].data());
+        result[indexes[j]] = addresses[indexes[j]].compare(2, std::string::npos, lowerAddresses[j]) == 0;
     }
-    return normalizedAddr;
+    return result;
 }
 
-std::string DeriveAESKeyFromPasswordDefault(const std::string& password, std::string& newsalt)
+std::string DeriveAESKeyFromPasswordDefault(const std::string& password, std::string& newsalt, const ScryptParams& kdfParams)
 {
     std::string aeskey = "";
     uint8_t derivedKey[EC_KEY_LENGTH] = {0};
-    //Стандартные значения параметров наследования aes-ключа
-    uint64_t N = SCRYPT_DEFAULT_N;//Можно выбрать и другое
-    uint32_t r = SCRYPT_DEFAULT_r;
-    uint32_t p = SCRYPT_DEFAULT_p;
+    //Параметры наследования aes-ключа из профиля
+    uint64_t N = kdfParams.n;
+    uint32_t r = kdfParams.r;
+    uint32_t p = kdfParams.p;
     //Генерируем произвольную "соль"
     uint8_t salt[EC_KEY_LENGTH] = {0};
     if (password.empty())
         return "";
     libscrypt_salt_gen(salt, EC_KEY_LENGTH);
-    libscrypt_scrypt((const uint8_t*)password.c_str(), password.size(),
+    const int resultScrypt = libscrypt_scrypt((const uint8_t*)password.c_str(), password.size(),
                         salt, EC_KEY_LENGTH,
                         N, r, p,
                         derivedKey, EC_KEY_LENGTH);
+    CHECK(resultScrypt == 0, "scrypt error " + std::to_string(errno));
     newsalt = std::string((char*)salt, EC_KEY_LENGTH);
     return std::string((char*)derivedKey, EC_KEY_LENGTH);
 }
@@ -101,9 +152,7 @@ std::string AddressFromPrivateKey(const std::string& privkey)
         for (i = 0; i < EC_KEY_LENGTH; ++i)
             pubkeybufnew[EC_KEY_LENGTH*2-1-i] = pubkeybuf[EC_KEY_LENGTH+i];
         //Считаем хэш от ключа
-        CryptoPP::Keccak k(EC_KEY_LENGTH);
-        k.Update((uint8_t*)&pubkeybufnew, EC_PUB_KEY_LENGTH-1);
-        k.TruncatedFinal(hs, EC_KEY_LENGTH);
+        Keccak256(pubkeybufnew, EC_PUB_KEY_LENGTH-1, hs);
         //Берем последние 20 байт в качестве адреса
         address = std::string((char*)hs+12, 20);
     }
@@ -159,7 +208,7 @@ std::string CreateKeyFile(const CertParams& certparams)
     return keyfile;
 }
 
-std::pair<std::string, std::string> EncodePrivKey(const std::string& privkey, const std::string& password)
+std::pair<std::string, std::string> EncodePrivKey(const std::string& privkey, const std::string& password, const ScryptParams& kdfParams)
 {
     CertParams certparams;
     std::string jsonkey = "";
@@ -170,7 +219,7 @@ std::pair<std::string, std::string> EncodePrivKey(const std::string& privkey, co
     ciphertext.reserve(1000);
     if (!privkey.empty() && !password.empty())
     {
-        std::string derivedkey = DeriveAESKeyFromPasswordDefault(password, newsalt);
+        std::string derivedkey = DeriveAESKeyFromPasswordDefault(password, newsalt, kdfParams);
         if (!derivedkey.empty())
         {
             //Создаем произвольный вектор инициализации
@@ -185,16 +234,14 @@ std::pair<std::string, std::string> EncodePrivKey(const std::string& privkey, co
             );
             //Считаем mac
             std::string hashdata = derivedkey.substr(16, 16) + ciphertext;
-            CryptoPP::Keccak k(EC_KEY_LENGTH);
-            k.Update((uint8_t*)hashdata.c_str(), hashdata.size());
-            k.TruncatedFinal(hsmac, EC_KEY_LENGTH);
+            Keccak256((const uint8_t*)hashdata.data(), hashdata.size(), hsmac);
             //Заполняем структуру
             certparams.ciphertext = ciphertext;
             certparams.iv = std::string((char*)iv, EC_KEY_LENGTH/2);
             certparams.dklen = EC_KEY_LENGTH;
-            certparams.n = SCRYPT_DEFAULT_N;
-            certparams.p = SCRYPT_DEFAULT_p;
-            certparams.r = SCRYPT_DEFAULT_r;
+            certparams.n = (int)kdfParams.n;
+            certparams.p = (int)kdfParams.p;
+            certparams.r = (int)kdfParams.r;
             certparams.salt = newsalt;
             certparams.mac = std::string((char*)hsmac, EC_KEY_LENGTH);
             certparams.address = AddressFromPrivateKey(privkey);
@@ -205,8 +252,8 @@ std::pair<std::string, std::string> EncodePrivKey(const std::string& privkey, co
     return std::make_pair("0x" + MixedCaseEncoding(certparams.address), jsonkey);
 }
 
-std::pair<std::string, std::string> CreateNewKey(const std::string& password) {
+std::pair<std::string, std::string> CreateNewKey(const std::string& password, const ScryptParams& kdfParams) {
     std::string rawprivkey = CreateRawECDSAKey();
     CHECK(!rawprivkey.empty(), "rawprivkey empty");
-    return EncodePrivKey(rawprivkey, password);
+    return EncodePrivKey(rawprivkey, password, kdfParams);
 }
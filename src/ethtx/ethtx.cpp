@@ -3,8 +3,7 @@
 #include <stdlib.h>
 #include <string>
 #include <vector>
-
-#include <cryptopp/keccak.h>
+#include <algorithm>
 
 #include <secp256k1/include/secp256k1_recovery.h>
 
@@ -12,19 +11,76 @@
 #include "utils2.h"
 #include "cert.h"
 #include "const.h"
+#include "keccak.h"
+#include "hex.h"
+#include "secp256k1ctx.h"
 
 #include "check.h"
 
-secp256k1_context const* getCtx()
-{
-        static std::unique_ptr<secp256k1_context, decltype(&secp256k1_context_destroy)> s_ctx{
-                secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY),
-                &secp256k1_context_destroy
-        };
-        return s_ctx.get();
+//Целые поля транзакции не длиннее 256 бит
+const static size_t MAX_INTEGER_SIZE = 32;
+const static size_t ADDRESS_SIZE = 20;
+const static size_t STORAGE_KEY_SIZE = 32;
+//Префикс типа транзакции EIP-1559 перед rlp
+const static uint8_t EIP1559_TYPE = 0x02;
+
+static size_t DecodeHexField(const std::string &hex, const std::string &name, uint8_t* out, size_t capacity) {
+    CHECK(hex.compare(0, 2, "0x") == 0, "Incorrect " + name + " " + hex);
+    const size_t hexSize = hex.size() - 2;
+    CHECK(HexDecodedSize(hexSize) <= capacity, "Incorrect " + name + " " + hex);
+    CHECK(HexDecode(hex.data() + 2, hexSize, out), "Incorrect " + name + " " + hex);
+    return HexDecodedSize(hexSize);
+}
+
+static void Uint64ToBuf(uint64_t value, uint8_t* out) {
+    for (size_t i = 0; i < sizeof(value); i++) {
+        out[sizeof(value) - 1 - i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+//rlp([[address, [storageKey, ...]], ...]). Адреса и ключи фиксированной длины,
+//поэтому их строки всегда кодируются с однобайтовым заголовком
+static std::vector<uint8_t> EncodeAccessList(const std::vector<EthAccessListEntry> &accessList) {
+    size_t decodedSize = 0;
+    for (const EthAccessListEntry &entry: accessList) {
+        decodedSize += ADDRESS_SIZE + entry.storageKeys.size() * STORAGE_KEY_SIZE;
+    }
+    std::vector<uint8_t> decoded(decodedSize);
+    std::vector<size_t> entrySizes(accessList.size());
+    size_t payloadSize = 0;
+    uint8_t* out = decoded.data();
+    for (size_t i = 0; i < accessList.size(); i++) {
+        const EthAccessListEntry &entry = accessList[i];
+        CHECK(entry.address.size() == 2 + 2 * ADDRESS_SIZE, "Incorrect accessList address " + entry.address);
+        DecodeHexField(entry.address, "accessList address", out, ADDRESS_SIZE);
+        out += ADDRESS_SIZE;
+        for (const std::string &key: entry.storageKeys) {
+            CHECK(key.size() == 2 + 2 * STORAGE_KEY_SIZE, "Incorrect storage key " + key);
+            DecodeHexField(key, "storage key", out, STORAGE_KEY_SIZE);
+            out += STORAGE_KEY_SIZE;
+        }
+        entrySizes[i] = 1 + ADDRESS_SIZE + RlpListSize(entry.storageKeys.size() * (1 + STORAGE_KEY_SIZE));
+        payloadSize += RlpListSize(entrySizes[i]);
+    }
+
+    std::vector<uint8_t> result(RlpListSize(payloadSize));
+    RlpWriter writer(result.data(), result.size());
+    writer.writeList(payloadSize);
+    const uint8_t* in = decoded.data();
+    for (size_t i = 0; i < accessList.size(); i++) {
+        const size_t keysCount = accessList[i].storageKeys.size();
+        writer.writeList(entrySizes[i]);
+        writer.writeString(in, ADDRESS_SIZE);
+        in += ADDRESS_SIZE;
+        writer.writeList(keysCount * (1 + STORAGE_KEY_SIZE));
+        for (size_t j = 0; j < keysCount; j++) {
+            writer.writeString(in, STORAGE_KEY_SIZE);
+            in += STORAGE_KEY_SIZE;
+        }
+    }
+    return result;
 }
 
-//Всем 16ричным строкам предшествует префикс 0x
 std::string SignTransaction(std::string rawprivkey,
                             std::string nonce,
                             std::string gasPrice,
@@ -33,64 +89,155 @@ std::string SignTransaction(std::string rawprivkey,
                             std::string value,
                             std::string data)
 {
-    CHECK(nonce.find("0x") == 0, "Incorrect nonce " + nonce);
-    CHECK(gasPrice.find("0x") == 0, "Incorrect gasPrice " + gasPrice);
-    CHECK(gasLimit.find("0x") == 0, "Incorrect gasLimit " + gasLimit);
-    CHECK(to.find("0x") == 0, "Incorrect to " + to);
-    CHECK(to.size() == 42, "Incorrect to " + to);
-    CHECK(value.find("0x") == 0, "Incorrect value " + value);
-    if (!data.empty()) {
-        CHECK(data.find("0x") == 0, "Incorrect value " + value);
+    EthTransaction tx;
+    tx.nonce = nonce;
+    tx.gasPrice = gasPrice;
+    tx.gasLimit = gasLimit;
+    tx.to = to;
+    tx.value = value;
+    tx.data = data;
+    return SignTransaction(rawprivkey, tx);
+}
+
+std::string SignTransaction(const std::string &rawprivkey, const EthTransaction &tx)
+{
+    CHECK(rawprivkey.size() == EC_KEY_LENGTH, "Incorrect private key size");
+    return SignTransaction((const uint8_t*)rawprivkey.data(), tx);
+}
+
+//Всем 16ричным строкам предшествует префикс 0x.
+//Транзакция без подписи и с подписью кодируется в один буфер, размер которого считается заранее
+std::string SignTransaction(const uint8_t *rawprivkey, const EthTransaction &tx)
+{
+    const bool isEip1559 = tx.type == EthTransactionType::EIP1559;
+    CHECK(isEip1559 || tx.type == EthTransactionType::LEGACY, "Unsupported transaction type");
+    //v = chainId * 2 + 35 + recid должен поместиться в 64 бита
+    CHECK(tx.chainId != 0 && tx.chainId <= (UINT64_MAX - 36) / 2, "Incorrect chainId");
+    CHECK(isEip1559 || tx.accessList.empty(), "accessList is not supported by legacy transaction");
+
+    uint8_t chainIdBuf[sizeof(uint64_t)];
+    Uint64ToBuf(tx.chainId, chainIdBuf);
+    uint8_t nonceBuf[MAX_INTEGER_SIZE];
+    uint8_t gasPriceBuf[MAX_INTEGER_SIZE];
+    uint8_t maxPriorityFeeBuf[MAX_INTEGER_SIZE];
+    uint8_t maxFeeBuf[MAX_INTEGER_SIZE];
+    uint8_t gasLimitBuf[MAX_INTEGER_SIZE];
+    uint8_t valueBuf[MAX_INTEGER_SIZE];
+    uint8_t toBuf[ADDRESS_SIZE];
+    const size_t nonceSize = DecodeHexField(tx.nonce, "nonce", nonceBuf, sizeof(nonceBuf));
+    size_t gasPriceSize = 0;
+    size_t maxPriorityFeeSize = 0;
+    size_t maxFeeSize = 0;
+    if (isEip1559) {
+        maxPriorityFeeSize = DecodeHexField(tx.maxPriorityFeePerGas, "maxPriorityFeePerGas", maxPriorityFeeBuf, sizeof(maxPriorityFeeBuf));
+        maxFeeSize = DecodeHexField(tx.maxFeePerGas, "maxFeePerGas", maxFeeBuf, sizeof(maxFeeBuf));
+    } else {
+        gasPriceSize = DecodeHexField(tx.gasPrice, "gasPrice", gasPriceBuf, sizeof(gasPriceBuf));
+    }
+    const size_t gasLimitSize = DecodeHexField(tx.gasLimit, "gasLimit", gasLimitBuf, sizeof(gasLimitBuf));
+    CHECK(tx.to.size() == 2 + 2 * ADDRESS_SIZE, "Incorrect to " + tx.to);
+    DecodeHexField(tx.to, "to", toBuf, sizeof(toBuf));
+    const size_t valueSize = DecodeHexField(tx.value, "value", valueBuf, sizeof(valueBuf));
+    std::vector<uint8_t> dataBuf;
+    if (!tx.data.empty()) {
+        CHECK(tx.data.compare(0, 2, "0x") == 0, "Incorrect data " + tx.data);
+        dataBuf.resize(HexDecodedSize(tx.data.size() - 2));
+        DecodeHexField(tx.data, "data", dataBuf.data(), dataBuf.size());
     }
-    nonce = nonce.substr(2);
-    gasPrice = gasPrice.substr(2);
-    gasLimit = gasLimit.substr(2);
-    to = to.substr(2);
-    value = value.substr(2);
-    if (!data.empty()) {
-        data = data.substr(2);
+    std::vector<uint8_t> accessList;
+    if (isEip1559) {
+        accessList = EncodeAccessList(tx.accessList);
     }
 
-    std::vector<std::string> settings;
-    settings.push_back(HexStringToDump(nonce));
-    settings.push_back(HexStringToDump(gasPrice));
-    settings.push_back(HexStringToDump(gasLimit));
-    settings.push_back(HexStringToDump(to));
-    settings.push_back(HexStringToDump(value));
-    settings.push_back(HexStringToDump(data));
+    //Legacy: [nonce, gasPrice, gasLimit, to, value, data]
+    //EIP1559: [chainId, nonce, maxPriorityFeePerGas, maxFeePerGas, gasLimit, to, value, data, accessList]
+    size_t commonSize =
+        RlpIntegerSize(nonceBuf, nonceSize) +
+        RlpIntegerSize(gasLimitBuf, gasLimitSize) +
+        RlpStringSize(toBuf, ADDRESS_SIZE) +
+        RlpIntegerSize(valueBuf, valueSize) +
+        RlpStringSize(dataBuf.data(), dataBuf.size());
+    if (isEip1559) {
+        commonSize +=
+            RlpIntegerSize(chainIdBuf, sizeof(chainIdBuf)) +
+            RlpIntegerSize(maxPriorityFeeBuf, maxPriorityFeeSize) +
+            RlpIntegerSize(maxFeeBuf, maxFeeSize) +
+            accessList.size();
+    } else {
+        commonSize += RlpIntegerSize(gasPriceBuf, gasPriceSize);
+    }
+    const auto writeCommon = [&](RlpWriter &writer) {
+        if (isEip1559) {
+            writer.writeInteger(chainIdBuf, sizeof(chainIdBuf));
+            writer.writeInteger(nonceBuf, nonceSize);
+            writer.writeInteger(maxPriorityFeeBuf, maxPriorityFeeSize);
+            writer.writeInteger(maxFeeBuf, maxFeeSize);
+        } else {
+            writer.writeInteger(nonceBuf, nonceSize);
+            writer.writeInteger(gasPriceBuf, gasPriceSize);
+        }
+        writer.writeInteger(gasLimitBuf, gasLimitSize);
+        writer.writeString(toBuf, ADDRESS_SIZE);
+        writer.writeInteger(valueBuf, valueSize);
+        writer.writeString(dataBuf.data(), dataBuf.size());
+        if (isEip1559) {
+            writer.writeEncoded(accessList.data(), accessList.size());
+        }
+    };
+
+    //Legacy подписывается вместе с [chainId, 0, 0] (EIP-155), EIP1559 - с байтом типа перед списком.
+    //Подпись занимает не больше v и двух 32-байтных целых
+    const size_t unsignedSize = isEip1559 ? commonSize : commonSize + RlpIntegerSize(chainIdBuf, sizeof(chainIdBuf)) + 2 * RlpIntegerSize(nullptr, 0);
+    const size_t maxSignedSize = commonSize + 1 + sizeof(uint64_t) + 2 * (1 + EC_KEY_LENGTH);
+    const size_t prefixSize = isEip1559 ? 1 : 0;
+    std::vector<uint8_t> rlp(prefixSize + RlpListSize(std::max(unsignedSize, maxSignedSize)));
+    if (isEip1559) {
+        rlp[0] = EIP1559_TYPE;
+    }
 
-    uint8_t hs[EC_KEY_LENGTH];
-    std::string rlp = SettingsToRLP(settings);
+    RlpWriter unsignedWriter(rlp.data() + prefixSize, rlp.size() - prefixSize);
+    unsignedWriter.writeList(unsignedSize);
+    writeCommon(unsignedWriter);
+    if (!isEip1559) {
+        unsignedWriter.writeInteger(chainIdBuf, sizeof(chainIdBuf));
+        unsignedWriter.writeInteger(nullptr, 0);
+        unsignedWriter.writeInteger(nullptr, 0);
+    }
 
-    CryptoPP::Keccak k(EC_KEY_LENGTH);
-    k.Update((uint8_t*)rlp.c_str(), rlp.size());
-    k.TruncatedFinal(hs, EC_KEY_LENGTH);
+    uint8_t hs[EC_KEY_LENGTH];
+    Keccak256(rlp.data(), prefixSize + unsignedWriter.size(), hs);
 
     auto* ctx = getCtx();
     secp256k1_ecdsa_recoverable_signature rawSig;
-    const bool res1 = secp256k1_ecdsa_sign_recoverable(ctx, &rawSig, (const unsigned char*)hs, (const unsigned char*)rawprivkey.c_str(), nullptr, nullptr);
+    const bool res1 = secp256k1_ecdsa_sign_recoverable(ctx, &rawSig, (const unsigned char*)hs, rawprivkey, nullptr, nullptr);
     CHECK(res1, "secp256k1_ecdsa_sign_recoverable error");
 
     uint8_t signature[64] = {0};
-    int v = 0;
-    const bool res2 = secp256k1_ecdsa_recoverable_signature_serialize_compact(ctx, signature, &v, &rawSig);
+    int recid = 0;
+    const bool res2 = secp256k1_ecdsa_recoverable_signature_serialize_compact(ctx, signature, &recid, &rawSig);
     CHECK(res2, "secp256k1_ecdsa_recoverable_signature_serialize_compact error");
-    if (v == 0 || v == 1) {
-        v += 37;
-    }
-
-    std::string vstr;
-    vstr.push_back((char)v);
-
-    settings.pop_back();
-    settings.pop_back();
-    settings.pop_back();
-
-    settings.push_back(vstr);
-    settings.push_back(std::string((char*)signature, EC_KEY_LENGTH));
-    settings.push_back(std::string((char*)signature + EC_KEY_LENGTH, EC_KEY_LENGTH));
-    std::string transaction =  SettingsToRLP(settings, false);
-    transaction = "0x" + DumpToHexString((const uint8_t*)transaction.c_str(), transaction.size());
+    //В EIP1559 вместо v пишется четность y
+    const uint64_t v = isEip1559 ? (uint64_t)recid : tx.chainId * 2 + 35 + recid;
+    uint8_t vBuf[sizeof(uint64_t)];
+    Uint64ToBuf(v, vBuf);
+
+    //r и s - целые, ведущие нули не кодируются
+    const size_t signedSize = commonSize +
+        RlpIntegerSize(vBuf, sizeof(vBuf)) +
+        RlpIntegerSize(signature, EC_KEY_LENGTH) +
+        RlpIntegerSize(signature + EC_KEY_LENGTH, EC_KEY_LENGTH);
+    RlpWriter signedWriter(rlp.data() + prefixSize, rlp.size() - prefixSize);
+    signedWriter.writeList(signedSize);
+    writeCommon(signedWriter);
+    signedWriter.writeInteger(vBuf, sizeof(vBuf));
+    signedWriter.writeInteger(signature, EC_KEY_LENGTH);
+    signedWriter.writeInteger(signature + EC_KEY_LENGTH, EC_KEY_LENGTH);
+
+    const size_t transactionSize = prefixSize + signedWriter.size();
+    std::string transaction(2 + HexEncodedSize(transactionSize), '\0');
+    transaction[0] = '0';
+    transaction[1] = 'x';
+    HexEncode(rlp.data(), transactionSize, &transaction[2]);
 
     return transaction;
 }
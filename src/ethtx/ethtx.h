@@ -2,10 +2,38 @@
 #define ETH_TX_H_
 
 #include <string>
+#include <vector>
 
-#include <secp256k1/include/secp256k1.h>
+#include <stdint.h>
 
-secp256k1_context const* getCtx();
+//Тип транзакции, EIP-2718
+enum class EthTransactionType {
+    LEGACY = 0,
+    EIP1559 = 2
+};
+
+//Адрес и ключи хранилища, к которым транзакция обращается заранее (EIP-2930)
+struct EthAccessListEntry {
+    std::string address;
+    std::vector<std::string> storageKeys;
+};
+
+//Все числа и байты - 16ричные строки с префиксом 0x.
+//Для LEGACY используется gasPrice, для EIP1559 - maxPriorityFeePerGas, maxFeePerGas и accessList
+struct EthTransaction {
+    std::string nonce;
+    std::string gasPrice;
+    std::string gasLimit;
+    std::string to;
+    std::string value;
+    std::string data;
+
+    EthTransactionType type = EthTransactionType::LEGACY;
+    uint64_t chainId = 1;
+    std::string maxPriorityFeePerGas;
+    std::string maxFeePerGas;
+    std::vector<EthAccessListEntry> accessList;
+};
 
 std::string SignTransaction(std::string rawprivkey,
                             std::string nonce,
@@ -15,4 +43,11 @@ std::string SignTransaction(std::string rawprivkey,
                             std::string value,
                             std::string data);
 
+//Legacy транзакция подписывается по EIP-155 с tx.chainId,
+//EIP1559 возвращается в виде 0x02 || rlp(...)
+std::string SignTransaction(const std::string &rawprivkey, const EthTransaction &tx);
+
+//rawprivkey - EC_KEY_LENGTH байт, копия ключа не создается
+std::string SignTransaction(const uint8_t *rawprivkey, const EthTransaction &tx);
+
 #endif // ETH_TX_H_
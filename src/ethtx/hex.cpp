@@ -0,0 +1,184 @@
+#include "hex.h"
+
+#include "scrypt/cpufeatures.h"
+
+#ifdef LIBSCRYPT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+//Все преобразования без ветвлений и табличных обращений по значению данных,
+//поэтому время не зависит от ключей и шифротекстов, которые через них проходят
+
+//0..9 -> '0'..'9', 10..15 -> 'a'..'f'
+static inline char encodeNibble(unsigned int n)
+{
+    return (char)(n + '0' + (((9U - n) >> 8) & ('a' - '0' - 10)));
+}
+
+//Возвращает значение hex символа, в valid - 0xff для hex символа и 0 для остальных
+static inline unsigned int decodeChar(unsigned char c, unsigned int &valid)
+{
+    const unsigned int num = c ^ 48U;
+    const unsigned int numMask = ((num - 10U) >> 8) & 0xff;
+    const unsigned int alpha = (c & ~32U) - 55U;
+    const unsigned int alphaMask = (((alpha - 10U) ^ (alpha - 16U)) >> 8) & 0xff;
+    valid = numMask | alphaMask;
+    return (numMask & num) | (alphaMask & alpha);
+}
+
+#ifdef LIBSCRYPT_X86_SIMD
+
+static inline __m128i encodeNibbles16(__m128i n)
+{
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letters);
+}
+
+//Кодирует блоки по 16 байт, возвращает число обработанных байт
+static size_t hexEncodeSse2(const uint8_t* data, size_t size, char* hex)
+{
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        const __m128i hi = encodeNibbles16(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        const __m128i lo = encodeNibbles16(_mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i*)(hex + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(hex + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+//Значения 16 символов, в invalid накапливаются байты 0xff на месте не hex символов
+static inline __m128i decodeChars16(__m128i c, __m128i &invalid)
+{
+    const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    const __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(isDigit, isAlpha), _mm_set1_epi8(-1)));
+    return _mm_or_si128(
+        _mm_and_si128(isDigit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+        _mm_and_si128(isAlpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)))
+    );
+}
+
+//Пары значений (старшая тетрада, младшая) в 16-битных словах -> байт в младшей половине слова
+static inline __m128i joinNibbles16(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), 4), _mm_srli_epi16(v, 8));
+}
+
+//Декодирует блоки по 16 байт результата, возвращает число записанных байт
+static size_t hexDecodeSse2(const char* hex, size_t size, uint8_t* data, __m128i &invalid)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v0 = decodeChars16(_mm_loadu_si128((const __m128i*)(hex + 2 * i)), invalid);
+        const __m128i v1 = decodeChars16(_mm_loadu_si128((const __m128i*)(hex + 2 * i + 16)), invalid);
+        _mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(joinNibbles16(v0), joinNibbles16(v1)));
+    }
+    return i;
+}
+
+static inline LIBSCRYPT_TARGET_AVX2 __m256i encodeNibbles32(__m256i n)
+{
+    const __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+    return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')), letters);
+}
+
+static LIBSCRYPT_TARGET_AVX2 size_t hexEncodeAvx2(const uint8_t* data, size_t size, char* hex)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        const __m256i hi = encodeNibbles32(_mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        const __m256i lo = encodeNibbles32(_mm256_and_si256(v, mask));
+        //unpack работает внутри 128-битных половин, permute возвращает порядок байт
+        const __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)(hex + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i*)(hex + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i;
+}
+
+static inline LIBSCRYPT_TARGET_AVX2 __m256i decodeChars32(__m256i c, __m256i &invalid)
+{
+    const __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    const __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    const __m256i isAlpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    invalid = _mm256_or_si256(invalid, _mm256_andnot_si256(_mm256_or_si256(isDigit, isAlpha), _mm256_set1_epi8(-1)));
+    return _mm256_or_si256(
+        _mm256_and_si256(isDigit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+        _mm256_and_si256(isAlpha, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)))
+    );
+}
+
+static inline LIBSCRYPT_TARGET_AVX2 __m256i joinNibbles32(__m256i v)
+{
+    return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x00ff)), 4), _mm256_srli_epi16(v, 8));
+}
+
+static LIBSCRYPT_TARGET_AVX2 size_t hexDecodeAvx2(const char* hex, size_t size, uint8_t* data, __m128i &invalid)
+{
+    __m256i invalid256 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v0 = decodeChars32(_mm256_loadu_si256((const __m256i*)(hex + 2 * i)), invalid256);
+        const __m256i v1 = decodeChars32(_mm256_loadu_si256((const __m256i*)(hex + 2 * i + 32)), invalid256);
+        const __m256i packed = _mm256_packus_epi16(joinNibbles32(v0), joinNibbles32(v1));
+        _mm256_storeu_si256((__m256i*)(data + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    invalid = _mm_or_si128(invalid, _mm_or_si128(_mm256_castsi256_si128(invalid256), _mm256_extracti128_si256(invalid256, 1)));
+    return i;
+}
+
+#endif
+
+void HexEncode(const uint8_t* data, size_t size, char* hex)
+{
+    size_t i = 0;
+#ifdef LIBSCRYPT_X86_SIMD
+    if (size >= 32 && (libscrypt_cpu_features() & LIBSCRYPT_CPU_AVX2)) {
+        i = hexEncodeAvx2(data, size, hex);
+    }
+    i += hexEncodeSse2(data + i, size - i, hex + 2 * i);
+#endif
+    for (; i < size; ++i) {
+        hex[2 * i] = encodeNibble(data[i] >> 4);
+        hex[2 * i + 1] = encodeNibble(data[i] & 0xf);
+    }
+}
+
+bool HexDecode(const char* hex, size_t hexSize, uint8_t* data)
+{
+    unsigned int valid = 0xff;
+    if (hexSize % 2 == 1) {
+        unsigned int v;
+        data[0] = (uint8_t)decodeChar(hex[0], v);
+        valid &= v;
+        ++hex;
+        --hexSize;
+        ++data;
+    }
+
+    const size_t size = hexSize / 2;
+    size_t i = 0;
+#ifdef LIBSCRYPT_X86_SIMD
+    __m128i invalid = _mm_setzero_si128();
+    if (size >= 32 && (libscrypt_cpu_features() & LIBSCRYPT_CPU_AVX2)) {
+        i = hexDecodeAvx2(hex, size, data, invalid);
+    }
+    i += hexDecodeSse2(hex + 2 * i, size - i, data + i, invalid);
+    valid &= (_mm_movemask_epi8(invalid) == 0) ? 0xff : 0;
+#endif
+    for (; i < size; ++i) {
+        unsigned int v1, v2;
+        const unsigned int hi = decodeChar(hex[2 * i], v1);
+        const unsigned int lo = decodeChar(hex[2 * i + 1], v2);
+        valid &= v1 & v2;
+        data[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return valid == 0xff;
+}
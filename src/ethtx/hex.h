@@ -0,0 +1,26 @@
+#ifndef ETHTX_HEX
+#define ETHTX_HEX
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Размер hex-строки для size байт
+inline size_t HexEncodedSize(size_t size) {
+    return size * 2;
+}
+
+//Размер дампа для hex-строки. Строка нечетной длины дополняется ведущим нулем
+inline size_t HexDecodedSize(size_t hexSize) {
+    return (hexSize + 1) / 2;
+}
+
+//Пишет в hex HexEncodedSize(size) символов в нижнем регистре, без завершающего нуля.
+//Не выделяет память, время работы не зависит от данных
+void HexEncode(const uint8_t* data, size_t size, char* hex);
+
+//Пишет в data HexDecodedSize(hexSize) байт. Принимает оба регистра, префикс 0x не допускается.
+//Возвращает false, если встретился не hex символ; содержимое data тогда не определено.
+//Не выделяет память, время работы не зависит от данных
+bool HexDecode(const char* hex, size_t hexSize, uint8_t* data);
+
+#endif
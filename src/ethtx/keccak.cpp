@@ -0,0 +1,263 @@
+#include "keccak.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "scrypt/cpufeatures.h"
+
+#ifdef LIBSCRYPT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+//Размер блока Keccak-256: (1600 - 2 * 256) / 8 байт
+const static size_t KECCAK_RATE = 136;
+const static size_t KECCAK_RATE_WORDS = KECCAK_RATE / 8;
+const static size_t KECCAK_ROUNDS = 24;
+
+const static uint64_t KECCAK_RC[KECCAK_ROUNDS] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+//Раунд Keccak-f[1600], развернутый по словам состояния: theta, rho и pi, chi, iota.
+//Операции над словами передаются параметрами, чтобы один раунд служил и скалярному, и AVX2 коду
+#define KECCAK_ROUND(W, XOR, ROTL, ANDN, st, rc) do { \
+    const W c0 = XOR(XOR(XOR(st[0], st[5]), XOR(st[10], st[15])), st[20]); \
+    const W c1 = XOR(XOR(XOR(st[1], st[6]), XOR(st[11], st[16])), st[21]); \
+    const W c2 = XOR(XOR(XOR(st[2], st[7]), XOR(st[12], st[17])), st[22]); \
+    const W c3 = XOR(XOR(XOR(st[3], st[8]), XOR(st[13], st[18])), st[23]); \
+    const W c4 = XOR(XOR(XOR(st[4], st[9]), XOR(st[14], st[19])), st[24]); \
+    const W d0 = XOR(c4, ROTL(c1, 1)); \
+    const W d1 = XOR(c0, ROTL(c2, 1)); \
+    const W d2 = XOR(c1, ROTL(c3, 1)); \
+    const W d3 = XOR(c2, ROTL(c4, 1)); \
+    const W d4 = XOR(c3, ROTL(c0, 1)); \
+    const W b0 = XOR(st[0], d0); \
+    const W b1 = ROTL(XOR(st[6], d1), 44); \
+    const W b2 = ROTL(XOR(st[12], d2), 43); \
+    const W b3 = ROTL(XOR(st[18], d3), 21); \
+    const W b4 = ROTL(XOR(st[24], d4), 14); \
+    const W b5 = ROTL(XOR(st[3], d3), 28); \
+    const W b6 = ROTL(XOR(st[9], d4), 20); \
+    const W b7 = ROTL(XOR(st[10], d0), 3); \
+    const W b8 = ROTL(XOR(st[16], d1), 45); \
+    const W b9 = ROTL(XOR(st[22], d2), 61); \
+    const W b10 = ROTL(XOR(st[1], d1), 1); \
+    const W b11 = ROTL(XOR(st[7], d2), 6); \
+    const W b12 = ROTL(XOR(st[13], d3), 25); \
+    const W b13 = ROTL(XOR(st[19], d4), 8); \
+    const W b14 = ROTL(XOR(st[20], d0), 18); \
+    const W b15 = ROTL(XOR(st[4], d4), 27); \
+    const W b16 = ROTL(XOR(st[5], d0), 36); \
+    const W b17 = ROTL(XOR(st[11], d1), 10); \
+    const W b18 = ROTL(XOR(st[17], d2), 15); \
+    const W b19 = ROTL(XOR(st[23], d3), 56); \
+    const W b20 = ROTL(XOR(st[2], d2), 62); \
+    const W b21 = ROTL(XOR(st[8], d3), 55); \
+    const W b22 = ROTL(XOR(st[14], d4), 39); \
+    const W b23 = ROTL(XOR(st[15], d0), 41); \
+    const W b24 = ROTL(XOR(st[21], d1), 2); \
+    st[0] = XOR(b0, ANDN(b1, b2)); \
+    st[1] = XOR(b1, ANDN(b2, b3)); \
+    st[2] = XOR(b2, ANDN(b3, b4)); \
+    st[3] = XOR(b3, ANDN(b4, b0)); \
+    st[4] = XOR(b4, ANDN(b0, b1)); \
+    st[5] = XOR(b5, ANDN(b6, b7)); \
+    st[6] = XOR(b6, ANDN(b7, b8)); \
+    st[7] = XOR(b7, ANDN(b8, b9)); \
+    st[8] = XOR(b8, ANDN(b9, b5)); \
+    st[9] = XOR(b9, ANDN(b5, b6)); \
+    st[10] = XOR(b10, ANDN(b11, b12)); \
+    st[11] = XOR(b11, ANDN(b12, b13)); \
+    st[12] = XOR(b12, ANDN(b13, b14)); \
+    st[13] = XOR(b13, ANDN(b14, b10)); \
+    st[14] = XOR(b14, ANDN(b10, b11)); \
+    st[15] = XOR(b15, ANDN(b16, b17)); \
+    st[16] = XOR(b16, ANDN(b17, b18)); \
+    st[17] = XOR(b17, ANDN(b18, b19)); \
+    st[18] = XOR(b18, ANDN(b19, b15)); \
+    st[19] = XOR(b19, ANDN(b15, b16)); \
+    st[20] = XOR(b20, ANDN(b21, b22)); \
+    st[21] = XOR(b21, ANDN(b22, b23)); \
+    st[22] = XOR(b22, ANDN(b23, b24)); \
+    st[23] = XOR(b23, ANDN(b24, b20)); \
+    st[24] = XOR(b24, ANDN(b20, b21)); \
+    st[0] = XOR(st[0], rc); \
+} while (0)
+
+const static uint8_t ZERO_BLOCK[KECCAK_RATE] = {0};
+
+static inline uint64_t rotl64(uint64_t x, int n)
+{
+    return (x << n) | (x >> (64 - n));
+}
+
+static inline uint64_t load64(const uint8_t* p)
+{
+    uint64_t result = 0;
+    for (int i = 7; i >= 0; --i) {
+        result = (result << 8) | p[i];
+    }
+    return result;
+}
+
+static inline void store64(uint8_t* p, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+#define XOR64(a, b) ((a) ^ (b))
+#define ROTL64(a, n) rotl64(a, n)
+#define ANDN64(a, b) (~(a) & (b))
+
+static void keccakf(uint64_t st[25])
+{
+    for (size_t round = 0; round < KECCAK_ROUNDS; ++round) {
+        KECCAK_ROUND(uint64_t, XOR64, ROTL64, ANDN64, st, KECCAK_RC[round]);
+    }
+}
+
+//Последний блок сообщения: остаток, затем паддинг 0x01 ... 0x80
+static void padBlock(const uint8_t* data, size_t rest, uint8_t* block)
+{
+    memset(block, 0, KECCAK_RATE);
+    memcpy(block, data, rest);
+    block[rest] ^= 0x01;
+    block[KECCAK_RATE - 1] ^= 0x80;
+}
+
+void Keccak256(const uint8_t* data, size_t size, uint8_t* hash)
+{
+    uint64_t st[25] = {0};
+    uint8_t block[KECCAK_RATE];
+    for (;;) {
+        const uint8_t* p = data;
+        const bool isLast = size < KECCAK_RATE;
+        if (isLast) {
+            padBlock(data, size, block);
+            p = block;
+        }
+        for (size_t i = 0; i < KECCAK_RATE_WORDS; ++i) {
+            st[i] ^= load64(p + 8 * i);
+        }
+        keccakf(st);
+        if (isLast) {
+            break;
+        }
+        data += KECCAK_RATE;
+        size -= KECCAK_RATE;
+    }
+    for (size_t i = 0; i < KECCAK256_HASH_LENGTH / 8; ++i) {
+        store64(hash + 8 * i, st[i]);
+    }
+}
+
+Keccak256Hash Keccak256(const std::string& data)
+{
+    Keccak256Hash hash;
+    Keccak256((const uint8_t*)data.data(), data.size(), hash.data());
+    return hash;
+}
+
+#ifdef LIBSCRYPT_X86_SIMD
+
+#define XOR256(a, b) _mm256_xor_si256(a, b)
+#define ROTL256(a, n) _mm256_or_si256(_mm256_slli_epi64(a, n), _mm256_srli_epi64(a, 64 - (n)))
+#define ANDN256(a, b) _mm256_andnot_si256(a, b)
+
+//Keccak-f[1600] над 4 независимыми состояниями, по одному в каждом 64-битном слове регистров
+static LIBSCRYPT_TARGET_AVX2 void keccakf4(__m256i st[25])
+{
+    for (size_t round = 0; round < KECCAK_ROUNDS; ++round) {
+        KECCAK_ROUND(__m256i, XOR256, ROTL256, ANDN256, st, _mm256_set1_epi64x((long long)KECCAK_RC[round]));
+    }
+}
+
+//Хэширует count <= 4 сообщений разной длины. Сообщение, у которого блоки кончились,
+//дальше впитывает нулевые блоки, а его хэш забирается сразу после последнего блока
+static LIBSCRYPT_TARGET_AVX2 void keccak256x4(const uint8_t* const* data, const size_t* sizes, size_t count, uint8_t* const* hashes)
+{
+    __m256i st[25];
+    for (size_t i = 0; i < 25; ++i) {
+        st[i] = _mm256_setzero_si256();
+    }
+    uint8_t padded[4][KECCAK_RATE];
+    size_t blocks[4] = {0, 0, 0, 0};
+    size_t maxBlocks = 0;
+    for (size_t l = 0; l < count; ++l) {
+        blocks[l] = sizes[l] / KECCAK_RATE + 1;
+        if (blocks[l] > maxBlocks) {
+            maxBlocks = blocks[l];
+        }
+    }
+
+    for (size_t b = 0; b < maxBlocks; ++b) {
+        const uint8_t* p[4];
+        for (size_t l = 0; l < 4; ++l) {
+            if (b >= blocks[l]) {
+                p[l] = ZERO_BLOCK;
+            } else if (b + 1 < blocks[l]) {
+                p[l] = data[l] + b * KECCAK_RATE;
+            } else {
+                padBlock(data[l] + b * KECCAK_RATE, sizes[l] - b * KECCAK_RATE, padded[l]);
+                p[l] = padded[l];
+            }
+        }
+        for (size_t i = 0; i < KECCAK_RATE_WORDS; ++i) {
+            const __m256i w = _mm256_set_epi64x((long long)load64(p[3] + 8 * i), (long long)load64(p[2] + 8 * i), (long long)load64(p[1] + 8 * i), (long long)load64(p[0] + 8 * i));
+            st[i] = _mm256_xor_si256(st[i], w);
+        }
+        keccakf4(st);
+        for (size_t l = 0; l < count; ++l) {
+            if (b + 1 != blocks[l]) {
+                continue;
+            }
+            for (size_t i = 0; i < KECCAK256_HASH_LENGTH / 8; ++i) {
+                uint64_t lanes[4];
+                _mm256_storeu_si256((__m256i*)lanes, st[i]);
+                store64(hashes[l] + 8 * i, lanes[l]);
+            }
+        }
+    }
+}
+
+#endif
+
+void Keccak256Batch(const uint8_t* const* data, const size_t* sizes, size_t count, uint8_t* const* hashes)
+{
+    size_t i = 0;
+#ifdef LIBSCRYPT_X86_SIMD
+    if (libscrypt_cpu_features() & LIBSCRYPT_CPU_AVX2) {
+        //Одно сообщение выгоднее считать скалярно
+        for (; i + 1 < count; i += 4) {
+            keccak256x4(data + i, sizes + i, std::min<size_t>(4, count - i), hashes + i);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        Keccak256(data[i], sizes[i], hashes[i]);
+    }
+}
+
+std::vector<Keccak256Hash> Keccak256Batch(const std::vector<std::string>& data)
+{
+    std::vector<Keccak256Hash> hashes(data.size());
+    std::vector<const uint8_t*> ptrs(data.size());
+    std::vector<size_t> sizes(data.size());
+    std::vector<uint8_t*> out(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        ptrs[i] = (const uint8_t*)data[i].data();
+        sizes[i] = data[i].size();
+        out[i] = hashes[i].data();
+    }
+    Keccak256Batch(ptrs.data(), sizes.data(), data.size(), out.data());
+    return hashes;
+}
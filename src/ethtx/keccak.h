@@ -0,0 +1,24 @@
+#ifndef ETHTX_KECCAK
+#define ETHTX_KECCAK
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <array>
+
+const size_t KECCAK256_HASH_LENGTH = 32;
+
+using Keccak256Hash = std::array<uint8_t, KECCAK256_HASH_LENGTH>;
+
+//Keccak-256 в варианте ethereum (паддинг 0x01, не SHA3). Без выделения памяти
+void Keccak256(const uint8_t* data, size_t size, uint8_t* hash);
+
+Keccak256Hash Keccak256(const std::string& data);
+
+//Хэширует count сообщений: hashes[i] = Keccak256(data[i], sizes[i]).
+//На процессорах с AVX2 обрабатывает по 4 сообщения за одну перестановку
+void Keccak256Batch(const uint8_t* const* data, const size_t* sizes, size_t count, uint8_t* const* hashes);
+
+std::vector<Keccak256Hash> Keccak256Batch(const std::vector<std::string>& data);
+
+#endif
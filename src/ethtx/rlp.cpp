@@ -1,72 +1,163 @@
 #include "rlp.h"
-#include "utils2.h"
 
 #include <cstring>
 
-template<typename PODType>
-size_t NumberSize(const PODType* value) {
-    PODType val = *value;
-    size_t currVal = 0;
-    while (val != 0) {
-        currVal++;
-        val /= 256;
+#include "check.h"
+
+const static uint8_t RLP_STRING_PREFIX = 0x80;
+const static uint8_t RLP_LIST_PREFIX = 0xC0;
+//Длины до 55 байт записываются в сам префикс, длинные - big-endian числом после него
+const static size_t RLP_SHORT_LENGTH = 55;
+
+static size_t LengthBytes(size_t size) {
+    size_t result = 0;
+    while (size != 0) {
+        result++;
+        size >>= 8;
     }
-    return currVal;
+    return result;
 }
 
-std::string EncodeField(std::string field) {
-    size_t fs = field.size();
-    std::string rslt = "";
-    if (fs == 1 && field.at(0) >= 0x0 && (uint8_t)field.at(0) <= 0x7F) {
-        if (field.at(0) == 0) {
-            rslt += 0x80;
-        } else {
-            rslt += field;
-        }
-    } else if (fs <= 55) {
-        char sz = 0x80 + fs;
-        rslt += sz;
-        rslt += field;
-    } else if (fs > 55 && fs < 0xFFFFFFFFFFFFFFFF) {
-        size_t sizelen = NumberSize(&fs);
-
-        const std::string bigint = IntegerToBuffer(fs);
-
-        char prefix = 0xB7 + sizelen;
-        rslt += prefix;
-        rslt += bigint.substr(0, sizelen);
-        rslt += field;
+static size_t HeaderSize(size_t size) {
+    return size <= RLP_SHORT_LENGTH ? 1 : 1 + LengthBytes(size);
+}
+
+static size_t SkipLeadingZeros(const uint8_t* data, size_t size) {
+    size_t i = 0;
+    while (i < size && data[i] == 0) {
+        i++;
     }
+    return i;
+}
+
+size_t RlpStringSize(const uint8_t* data, size_t size) {
+    if (size == 1 && data[0] < RLP_STRING_PREFIX) {
+        return 1;
+    }
+    return HeaderSize(size) + size;
+}
 
-    return rslt;
+size_t RlpIntegerSize(const uint8_t* data, size_t size) {
+    const size_t zeros = SkipLeadingZeros(data, size);
+    return RlpStringSize(data + zeros, size - zeros);
 }
 
-std::string CalcTotalSize(std::string dump) {
-    std::string rslt = "";
-    size_t ds = dump.size();
-    if (ds <= 55) {
-        char sz = 0xC0 + ds;
-        rslt += sz;
-        rslt += dump;
+size_t RlpListSize(size_t payloadSize) {
+    return HeaderSize(payloadSize) + payloadSize;
+}
+
+RlpWriter::RlpWriter(uint8_t* buffer, size_t capacity)
+    : buffer(buffer)
+    , capacity(capacity)
+{}
+
+void RlpWriter::writeHeader(uint8_t shortPrefix, size_t size) {
+    CHECK(capacity - pos >= HeaderSize(size), "Rlp buffer overflow");
+    if (size <= RLP_SHORT_LENGTH) {
+        buffer[pos++] = (uint8_t)(shortPrefix + size);
     } else {
-        size_t sizelen = NumberSize(&ds);
+        const size_t lengthBytes = LengthBytes(size);
+        buffer[pos++] = (uint8_t)(shortPrefix + RLP_SHORT_LENGTH + lengthBytes);
+        for (size_t i = lengthBytes; i > 0; i--) {
+            buffer[pos++] = (uint8_t)(size >> (8 * (i - 1)));
+        }
+    }
+}
 
-        const std::string bigint = IntegerToBuffer(ds);
+void RlpWriter::writeList(size_t payloadSize) {
+    writeHeader(RLP_LIST_PREFIX, payloadSize);
+}
 
-        char prefix = 0xF7 + sizelen;
-        rslt += prefix;
-        rslt += bigint.substr(0, sizelen);
-        rslt += dump;
+void RlpWriter::writeString(const uint8_t* data, size_t size) {
+    if (size == 1 && data[0] < RLP_STRING_PREFIX) {
+        CHECK(pos < capacity, "Rlp buffer overflow");
+        buffer[pos++] = data[0];
+        return;
     }
+    writeHeader(RLP_STRING_PREFIX, size);
+    CHECK(capacity - pos >= size, "Rlp buffer overflow");
+    if (size != 0) {
+        memcpy(buffer + pos, data, size);
+    }
+    pos += size;
+}
 
-    return rslt;
+void RlpWriter::writeInteger(const uint8_t* data, size_t size) {
+    const size_t zeros = SkipLeadingZeros(data, size);
+    writeString(data + zeros, size - zeros);
 }
 
-std::string RLP(const std::vector<std::string> fields) {
-    std::string dump = "";
-    for (size_t i = 0; i < fields.size(); ++i) {
-        dump += EncodeField(fields[i]);
+void RlpWriter::writeEncoded(const uint8_t* data, size_t size) {
+    CHECK(capacity - pos >= size, "Rlp buffer overflow");
+    if (size != 0) {
+        memcpy(buffer + pos, data, size);
+    }
+    pos += size;
+}
+
+RlpReader::RlpReader(const uint8_t* data, size_t size)
+    : data(data)
+    , size(size)
+{}
+
+RlpItem RlpReader::next() {
+    CHECK(pos < size, "Rlp: unexpected end");
+    const uint8_t prefix = data[pos];
+    if (prefix < RLP_STRING_PREFIX) {
+        pos++;
+        return RlpItem{false, data + pos - 1, 1};
+    }
+
+    const bool isList = prefix >= RLP_LIST_PREFIX;
+    const size_t shortLength = prefix - (isList ? RLP_LIST_PREFIX : RLP_STRING_PREFIX);
+    size_t length = shortLength;
+    size_t header = 1;
+    if (shortLength > RLP_SHORT_LENGTH) {
+        const size_t lengthBytes = shortLength - RLP_SHORT_LENGTH;
+        CHECK(lengthBytes <= sizeof(size_t) && size - pos > lengthBytes, "Rlp: incorrect length");
+        CHECK(data[pos + 1] != 0, "Rlp: non canonical length");
+        length = 0;
+        for (size_t i = 1; i <= lengthBytes; i++) {
+            length = (length << 8) | data[pos + i];
+        }
+        CHECK(length > RLP_SHORT_LENGTH, "Rlp: non canonical length");
+        header += lengthBytes;
+    }
+    CHECK(length <= size - pos - header, "Rlp: item exceeds input");
+    if (!isList && length == 1) {
+        CHECK(data[pos + header] >= RLP_STRING_PREFIX, "Rlp: non canonical single byte");
+    }
+
+    const RlpItem item{isList, data + pos + header, length};
+    pos += header + length;
+    return item;
+}
+
+RlpItem RlpReader::nextString() {
+    const RlpItem item = next();
+    CHECK(!item.isList, "Rlp: expected string");
+    return item;
+}
+
+RlpReader RlpReader::nextList() {
+    const RlpItem item = next();
+    CHECK(item.isList, "Rlp: expected list");
+    return RlpReader(item.data, item.size);
+}
+
+std::string RLP(const std::vector<std::string> &fields) {
+    const auto fieldSize = [](const std::string &field) -> size_t {
+        return (field.size() == 1 && field[0] == 0) ? 0 : field.size();
+    };
+    size_t payloadSize = 0;
+    for (const std::string &field: fields) {
+        payloadSize += RlpStringSize((const uint8_t*)field.data(), fieldSize(field));
+    }
+    std::string result(RlpListSize(payloadSize), '\0');
+    RlpWriter writer((uint8_t*)&result[0], result.size());
+    writer.writeList(payloadSize);
+    for (const std::string &field: fields) {
+        writer.writeString((const uint8_t*)field.data(), fieldSize(field));
     }
-    dump = CalcTotalSize(dump);
-    return dump;
+    return result;
 }
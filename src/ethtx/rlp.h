@@ -4,6 +4,82 @@
 #include <vector>
 #include <string>
 
-std::string RLP(const std::vector<std::string> fields);
+#include <stdint.h>
+#include <stddef.h>
+
+//Одиночный нулевой байт в fields кодируется как целое 0, то есть пустой строкой
+std::string RLP(const std::vector<std::string> &fields);
+
+//Размер закодированной строки байт
+size_t RlpStringSize(const uint8_t* data, size_t size);
+
+//Размер закодированного целого без знака (big-endian, ведущие нули отбрасываются)
+size_t RlpIntegerSize(const uint8_t* data, size_t size);
+
+//Размер списка с содержимым из payloadSize байт вместе с заголовком
+size_t RlpListSize(size_t payloadSize);
+
+//Пишет RLP в буфер, размер которого заранее посчитан функциями выше. Память не выделяет
+class RlpWriter {
+public:
+
+    RlpWriter(uint8_t* buffer, size_t capacity);
+
+    //Заголовок списка, элементы пишутся следом
+    void writeList(size_t payloadSize);
+
+    void writeString(const uint8_t* data, size_t size);
+
+    void writeInteger(const uint8_t* data, size_t size);
+
+    //Уже закодированный элемент копируется как есть
+    void writeEncoded(const uint8_t* data, size_t size);
+
+    size_t size() const {
+        return pos;
+    }
+
+private:
+
+    void writeHeader(uint8_t shortPrefix, size_t size);
+
+private:
+
+    uint8_t* const buffer;
+    const size_t capacity;
+    size_t pos = 0;
+};
+
+//Элемент RLP, data указывает в исходный буфер
+struct RlpItem {
+    bool isList;
+    const uint8_t* data;
+    size_t size;
+};
+
+//Читает RLP без копирования и выделения памяти.
+//На обрезанных и неканонических кодировках бросает исключение
+class RlpReader {
+public:
+
+    RlpReader(const uint8_t* data, size_t size);
+
+    bool isEnd() const {
+        return pos == size;
+    }
+
+    RlpItem next();
+
+    RlpItem nextString();
+
+    //Читатель элементов следующего списка
+    RlpReader nextList();
+
+private:
+
+    const uint8_t* const data;
+    const size_t size;
+    size_t pos = 0;
+};
 
 #endif
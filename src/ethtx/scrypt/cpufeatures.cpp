@@ -0,0 +1,90 @@
+#include <stdint.h>
+
+#include "cpufeatures.h"
+
+#ifdef LIBSCRYPT_X86_SIMD
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef LIBSCRYPT_X86_SIMD
+static void
+cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+	int r[4];
+
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	regs[0] = r[0];
+	regs[1] = r[1];
+	regs[2] = r[2];
+	regs[3] = r[3];
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t
+xgetbv(uint32_t index)
+{
+#ifdef _MSC_VER
+	return (_xgetbv(index));
+#else
+	uint32_t eax, edx;
+
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+	return (((uint64_t)edx << 32) | eax);
+#endif
+}
+
+static unsigned int
+detect_features(void)
+{
+	unsigned int features = 0;
+	uint32_t regs[4];
+	uint32_t max_leaf;
+	uint32_t ecx1;
+
+	cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	if (max_leaf < 1)
+		return (0);
+
+	cpuid(1, 0, regs);
+	if (regs[3] & (1u << 26))
+		features |= LIBSCRYPT_CPU_SSE2;
+	ecx1 = regs[2];
+	if (max_leaf < 7)
+		return (features);
+
+	cpuid(7, 0, regs);
+
+	/* AVX2 also needs the OS to save the ymm registers (OSXSAVE + XCR0). */
+	if ((regs[1] & (1u << 5)) != 0 && (ecx1 & (1u << 27)) != 0 &&
+	    (xgetbv(0) & 0x6) == 0x6)
+		features |= LIBSCRYPT_CPU_AVX2;
+
+	/* The SHA-NI transform also uses SSSE3 and SSE4.1 shuffles. */
+	if ((regs[1] & (1u << 29)) != 0 && (ecx1 & (1u << 9)) != 0 &&
+	    (ecx1 & (1u << 19)) != 0)
+		features |= LIBSCRYPT_CPU_SHA;
+
+	return (features);
+}
+#endif
+
+unsigned int
+libscrypt_cpu_features(void)
+{
+#ifdef LIBSCRYPT_X86_SIMD
+	static const unsigned int features = detect_features();
+
+	return (features);
+#else
+	return (0);
+#endif
+}
@@ -0,0 +1,30 @@
+#ifndef _CPUFEATURES_H_
+#define _CPUFEATURES_H_
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIBSCRYPT_X86_SIMD 1
+#endif
+
+/* GCC and clang need the target attribute to emit AVX2 code in a file built
+ * without -mavx2; MSVC emits any intrinsic without it. */
+#if defined(__GNUC__)
+#define LIBSCRYPT_TARGET_AVX2 __attribute__((target("avx2")))
+#define LIBSCRYPT_TARGET_SHA __attribute__((target("sha,sse4.1")))
+#else
+#define LIBSCRYPT_TARGET_AVX2
+#define LIBSCRYPT_TARGET_SHA
+#endif
+
+#define LIBSCRYPT_CPU_SSE2	0x1
+#define LIBSCRYPT_CPU_AVX2	0x2
+#define LIBSCRYPT_CPU_SHA	0x4	/* SHA extensions together with SSE4.1 */
+
+/**
+ * libscrypt_cpu_features():
+ * Return the LIBSCRYPT_CPU_* flags supported by the processor and the OS.
+ * The result is computed once by CPUID.
+ */
+unsigned int libscrypt_cpu_features(void);
+
+#endif /* !_CPUFEATURES_H_ */
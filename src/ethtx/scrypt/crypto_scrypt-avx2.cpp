@@ -0,0 +1,290 @@
+/*-
+ * Copyright 2009 Colin Percival
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file was originally written by Colin Percival as part of the Tarsnap
+ * online backup system.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpufeatures.h"
+#include "sysendian.h"
+
+#include "crypto_scrypt_smix.h"
+
+#ifdef LIBSCRYPT_X86_SIMD
+
+#include <immintrin.h>
+
+/*
+ * Two independent SMix lanes share each 256-bit register: the low 128 bits
+ * hold a row of lane 0 and the high 128 bits the same row of lane 1, both in
+ * the diagonal order of crypto_scrypt-sse.cpp.  BlockMix is serial inside a
+ * lane, so this is how AVX2 gets wider than SSE2 for scrypt.  Each lane keeps
+ * its own V in the SSE2 layout.
+ */
+
+LIBSCRYPT_TARGET_AVX2 static inline void
+blkcpy(__m256i * D, const __m256i * S, size_t L)
+{
+	size_t i;
+
+	for (i = 0; i < L; i++)
+		D[i] = S[i];
+}
+
+LIBSCRYPT_TARGET_AVX2 static inline void
+blkxor(__m256i * D, const __m256i * S, size_t L)
+{
+	size_t i;
+
+	for (i = 0; i < L; i++)
+		D[i] = _mm256_xor_si256(D[i], S[i]);
+}
+
+/**
+ * salsa20_8(B):
+ * Apply the salsa20/8 core to both lanes of the provided block.
+ */
+LIBSCRYPT_TARGET_AVX2 static inline void
+salsa20_8(__m256i B[4])
+{
+	__m256i X0, X1, X2, X3;
+	__m256i T;
+	size_t i;
+
+	X0 = B[0];
+	X1 = B[1];
+	X2 = B[2];
+	X3 = B[3];
+
+	for (i = 0; i < 8; i += 2) {
+#define R(X, T, b) \
+	X = _mm256_xor_si256(X, _mm256_slli_epi32(T, b)); \
+	X = _mm256_xor_si256(X, _mm256_srli_epi32(T, 32 - b));
+		/* Operate on "columns". */
+		T = _mm256_add_epi32(X0, X3);
+		R(X1, T, 7);
+		T = _mm256_add_epi32(X1, X0);
+		R(X2, T, 9);
+		T = _mm256_add_epi32(X2, X1);
+		R(X3, T, 13);
+		T = _mm256_add_epi32(X3, X2);
+		R(X0, T, 18);
+
+		/* Rearrange data. */
+		X1 = _mm256_shuffle_epi32(X1, 0x93);
+		X2 = _mm256_shuffle_epi32(X2, 0x4E);
+		X3 = _mm256_shuffle_epi32(X3, 0x39);
+
+		/* Operate on "rows". */
+		T = _mm256_add_epi32(X0, X1);
+		R(X3, T, 7);
+		T = _mm256_add_epi32(X3, X0);
+		R(X2, T, 9);
+		T = _mm256_add_epi32(X2, X3);
+		R(X1, T, 13);
+		T = _mm256_add_epi32(X1, X2);
+		R(X0, T, 18);
+
+		/* Rearrange data. */
+		X1 = _mm256_shuffle_epi32(X1, 0x39);
+		X2 = _mm256_shuffle_epi32(X2, 0x4E);
+		X3 = _mm256_shuffle_epi32(X3, 0x93);
+#undef R
+	}
+
+	B[0] = _mm256_add_epi32(B[0], X0);
+	B[1] = _mm256_add_epi32(B[1], X1);
+	B[2] = _mm256_add_epi32(B[2], X2);
+	B[3] = _mm256_add_epi32(B[3], X3);
+}
+
+/**
+ * blockmix_salsa8(Bin, Bout, X, r):
+ * Compute Bout = BlockMix_{salsa20/8, r}(Bin) for both lanes.  Bin and Bout
+ * are 8r registers; the temporary space X is 4 registers.
+ */
+LIBSCRYPT_TARGET_AVX2 static void
+blockmix_salsa8(const __m256i * Bin, __m256i * Bout, __m256i * X, size_t r)
+{
+	size_t i;
+
+	/* 1: X <-- B_{2r - 1} */
+	blkcpy(X, &Bin[8 * r - 4], 4);
+
+	/* 2: for i = 0 to 2r - 1 do */
+	for (i = 0; i < r; i++) {
+		/* 3: X <-- H(X \xor B_i) */
+		blkxor(X, &Bin[i * 8], 4);
+		salsa20_8(X);
+
+		/* 4: Y_i <-- X */
+		/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+		blkcpy(&Bout[i * 4], X, 4);
+
+		/* 3: X <-- H(X \xor B_i) */
+		blkxor(X, &Bin[i * 8 + 4], 4);
+		salsa20_8(X);
+
+		/* 4: Y_i <-- X */
+		/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+		blkcpy(&Bout[(r + i) * 4], X, 4);
+	}
+}
+
+/**
+ * integerify(B, r, lane):
+ * Return the result of parsing B_{2r-1} of the lane as a little-endian
+ * integer.
+ */
+static inline uint64_t
+integerify(const void * B, size_t r, size_t lane)
+{
+	const uint32_t * X = (const uint32_t *)((uintptr_t)(B) + (2 * r - 1) * 128);
+
+	return (((uint64_t)(X[3 * 8 + lane * 4 + 1]) << 32) + X[lane * 4]);
+}
+
+/* V_0[i] <-- low lanes of X, V_1[i] <-- high lanes of X */
+LIBSCRYPT_TARGET_AVX2 static inline void
+blkstore2(__m128i * V0, __m128i * V1, const __m256i * X, size_t L)
+{
+	size_t i;
+
+	for (i = 0; i < L; i++) {
+		_mm_store_si128(&V0[i], _mm256_castsi256_si128(X[i]));
+		_mm_store_si128(&V1[i], _mm256_extracti128_si256(X[i], 1));
+	}
+}
+
+/* X <-- X \xor (V_0[i], V_1[i]) */
+LIBSCRYPT_TARGET_AVX2 static inline void
+blkxor2(__m256i * X, const __m128i * V0, const __m128i * V1, size_t L)
+{
+	size_t i;
+
+	for (i = 0; i < L; i++) {
+		X[i] = _mm256_xor_si256(X[i], _mm256_inserti128_si256(
+		    _mm256_castsi128_si256(_mm_load_si128(&V0[i])),
+		    _mm_load_si128(&V1[i]), 1));
+	}
+}
+
+/**
+ * libscrypt_smix2_avx2(B0, B1, r, N, V, XY, progress_done, progress_total):
+ * Two-lane AVX2 SMix, see crypto_scrypt_smix.h.
+ */
+LIBSCRYPT_TARGET_AVX2 int
+libscrypt_smix2_avx2(uint8_t * B0, uint8_t * B1, size_t r, uint64_t N,
+    void * V0, void * XY0, uint64_t progress_done, uint64_t progress_total)
+{
+	__m128i * V[2] = { (__m128i *)V0, (__m128i *)V0 + 8 * r * N };
+	uint8_t * B[2] = { B0, B1 };
+	__m256i * X = (__m256i *)XY0;
+	__m256i * Y = &X[8 * r];
+	__m256i * Z = &X[16 * r];
+	uint32_t * X32 = (uint32_t *)X;
+	uint64_t i;
+	uint64_t j0, j1;
+	size_t k;
+	size_t lane;
+
+	/* 1: X <-- B */
+	for (lane = 0; lane < 2; lane++) {
+		for (k = 0; k < 32 * r; k++) {
+			X32[(k / 4) * 8 + lane * 4 + k % 4] =
+			    le32dec(&B[lane][((k & ~(size_t)15) + (k % 16 * 5 % 16)) * 4]);
+		}
+	}
+
+	/* 2: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		if ((i % PROGRESS_INTERVAL) == 0 &&
+		    libscrypt_report_progress(progress_done + 2 * i, progress_total) != 0)
+			return (-1);
+
+		/* 3: V_i <-- X */
+		blkstore2(&V[0][i * (8 * r)], &V[1][i * (8 * r)], X, 8 * r);
+
+		/* 4: X <-- H(X) */
+		blockmix_salsa8(X, Y, Z, r);
+
+		/* 3: V_i <-- X */
+		blkstore2(&V[0][(i + 1) * (8 * r)], &V[1][(i + 1) * (8 * r)], Y, 8 * r);
+
+		/* 4: X <-- H(X) */
+		blockmix_salsa8(Y, X, Z, r);
+	}
+
+	/* 6: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		if ((i % PROGRESS_INTERVAL) == 0 &&
+		    libscrypt_report_progress(progress_done + 2 * (N + i), progress_total) != 0)
+			return (-1);
+
+		/* 7: j <-- Integerify(X) mod N */
+		j0 = integerify(X, r, 0) & (N - 1);
+		j1 = integerify(X, r, 1) & (N - 1);
+
+		/* 8: X <-- H(X \xor V_j) */
+		blkxor2(X, &V[0][j0 * (8 * r)], &V[1][j1 * (8 * r)], 8 * r);
+		blockmix_salsa8(X, Y, Z, r);
+
+		/* 7: j <-- Integerify(X) mod N */
+		j0 = integerify(Y, r, 0) & (N - 1);
+		j1 = integerify(Y, r, 1) & (N - 1);
+
+		/* 8: X <-- H(X \xor V_j) */
+		blkxor2(Y, &V[0][j0 * (8 * r)], &V[1][j1 * (8 * r)], 8 * r);
+		blockmix_salsa8(Y, X, Z, r);
+	}
+
+	/* 10: B' <-- X */
+	for (lane = 0; lane < 2; lane++) {
+		for (k = 0; k < 32 * r; k++) {
+			le32enc(&B[lane][((k & ~(size_t)15) + (k % 16 * 5 % 16)) * 4],
+			    X32[(k / 4) * 8 + lane * 4 + k % 4]);
+		}
+	}
+
+	return (0);
+}
+
+#else
+
+int
+libscrypt_smix2_avx2(uint8_t * B0, uint8_t * B1, size_t r, uint64_t N,
+    void * V0, void * XY0, uint64_t progress_done, uint64_t progress_total)
+{
+	if (libscrypt_smix_nosse(B0, r, N, V0, XY0, progress_done, progress_total))
+		return (-1);
+	return (libscrypt_smix_nosse(B1, r, N, (uint8_t *)V0 + 128 * r * N, XY0,
+	    progress_done + 2 * N, progress_total));
+}
+
+#endif /* LIBSCRYPT_X86_SIMD */
@@ -0,0 +1,604 @@
+/*-
+ * Copyright 2009 Colin Percival
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file was originally written by Colin Percival as part of the Tarsnap
+ * online backup system.
+ */
+
+#include <sys/types.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sha256.h"
+#include "cpufeatures.h"
+
+#include "crypto_scrypt_smix.h"
+#include "libscrypt.h"
+
+static thread_local libscrypt_progress_callback progress_callback = NULL;
+static thread_local void * progress_arg = NULL;
+
+static std::atomic<int> forced_kernel(LIBSCRYPT_KERNEL_AUTO);
+static std::atomic<uint32_t> forced_threads(0);
+
+/* Lanes run on several threads only while their V fit in this much memory. */
+#define PARALLEL_MAX_MEMORY ((size_t)512 * 1024 * 1024)
+
+/* How often the calling thread reports progress of parallel lanes. */
+#define PARALLEL_PROGRESS_PERIOD_MS 50
+
+void
+libscrypt_set_thread_progress(libscrypt_progress_callback callback, void * arg)
+{
+	progress_callback = callback;
+	progress_arg = arg;
+}
+
+int
+libscrypt_report_progress(uint64_t done, uint64_t total)
+{
+	if (progress_callback == NULL)
+		return (0);
+	return (progress_callback(progress_arg, done, total));
+}
+
+static int
+kernel_supported(enum libscrypt_kernel kernel)
+{
+	switch (kernel) {
+	case LIBSCRYPT_KERNEL_AUTO:
+	case LIBSCRYPT_KERNEL_NOSSE:
+		return (1);
+	case LIBSCRYPT_KERNEL_SSE2:
+		return ((libscrypt_cpu_features() & LIBSCRYPT_CPU_SSE2) != 0);
+	case LIBSCRYPT_KERNEL_AVX2:
+		return ((libscrypt_cpu_features() & LIBSCRYPT_CPU_AVX2) != 0);
+	}
+	return (0);
+}
+
+int
+libscrypt_set_kernel(enum libscrypt_kernel kernel)
+{
+	if (!kernel_supported(kernel)) {
+		errno = ENOTSUP;
+		return (-1);
+	}
+	forced_kernel = kernel;
+	return (0);
+}
+
+void
+libscrypt_set_threads(uint32_t threads)
+{
+	forced_threads = threads;
+}
+
+enum libscrypt_kernel
+libscrypt_get_kernel(void)
+{
+	const enum libscrypt_kernel kernel = (enum libscrypt_kernel)forced_kernel.load();
+	unsigned int features;
+
+	if (kernel != LIBSCRYPT_KERNEL_AUTO)
+		return (kernel);
+	features = libscrypt_cpu_features();
+	if (features & LIBSCRYPT_CPU_AVX2)
+		return (LIBSCRYPT_KERNEL_AVX2);
+	if (features & LIBSCRYPT_CPU_SSE2)
+		return (LIBSCRYPT_KERNEL_SSE2);
+	return (LIBSCRYPT_KERNEL_NOSSE);
+}
+
+/* Scratch memory of one thread: V and XY for one or two lanes. */
+struct scratch {
+	void * XY0;
+	void * V;
+	void * XY;
+	size_t Vlen;
+};
+
+static int
+scratch_alloc(struct scratch * S, size_t Vlen, size_t XYlen)
+{
+	S->Vlen = Vlen;
+#ifdef HAVE_POSIX_MEMALIGN
+	if ((errno = posix_memalign(&S->XY0, 64, XYlen)) != 0)
+		goto err0;
+	S->XY = S->XY0;
+#else
+	if ((S->XY0 = malloc(XYlen + 63)) == NULL)
+		goto err0;
+	S->XY = (void *)(((uintptr_t)(S->XY0) + 63) & ~ (uintptr_t)(63));
+#endif
+	if ((S->V = libscrypt_arena_acquire(Vlen)) == NULL)
+		goto err1;
+	return (0);
+
+err1:
+	free(S->XY0);
+err0:
+	return (-1);
+}
+
+static void
+scratch_free(struct scratch * S)
+{
+	libscrypt_arena_release(S->V);
+	free(S->XY0);
+}
+
+/* One SMix lane: block B_i of 128r bytes of some scrypt instance. */
+struct lane {
+	uint8_t * B;
+	size_t r;
+	uint64_t N;
+};
+
+/*
+ * Unit of work: one lane, or two lanes with equal N and r for the AVX2
+ * kernel.  offset is where the unit starts in the progress of the whole job.
+ */
+struct unit {
+	size_t first;
+	size_t second;
+	int paired;
+	uint64_t offset;
+};
+
+struct lanes_job {
+	std::vector<lane> lanes;
+	std::vector<unit> units;
+	libscrypt_smix_func smix;
+	uint64_t total;
+	size_t Vlen;
+	size_t XYlen;
+};
+
+static int
+lane_order(const struct lane & a, const struct lane & b)
+{
+	return (a.N < b.N || (a.N == b.N && a.r < b.r));
+}
+
+/**
+ * job_init(job, kernel):
+ * Split the lanes of the job into units and size the scratch of one thread.
+ * With the AVX2 kernel, lanes with equal N and r are paired, also across
+ * different scrypt instances.
+ */
+static void
+job_init(struct lanes_job * job, enum libscrypt_kernel kernel)
+{
+	std::vector<lane> & lanes = job->lanes;
+	size_t i;
+	uint64_t offset = 0;
+
+	job->smix = kernel == LIBSCRYPT_KERNEL_NOSSE ?
+	    libscrypt_smix_nosse : libscrypt_smix_sse2;
+	job->Vlen = 0;
+	job->XYlen = 0;
+	job->units.clear();
+	if (kernel == LIBSCRYPT_KERNEL_AVX2)
+		std::stable_sort(lanes.begin(), lanes.end(), lane_order);
+
+	for (i = 0; i < lanes.size();) {
+		struct unit U;
+		size_t count;
+
+		U.first = i;
+		U.second = i;
+		U.paired = kernel == LIBSCRYPT_KERNEL_AVX2 && i + 1 < lanes.size() &&
+		    lanes[i + 1].N == lanes[i].N && lanes[i + 1].r == lanes[i].r;
+		if (U.paired)
+			U.second = i + 1;
+		U.offset = offset;
+		count = U.paired ? 2 : 1;
+
+		offset += 2 * lanes[i].N * count;
+		job->Vlen = std::max(job->Vlen, count * 128 * lanes[i].r * lanes[i].N);
+		job->XYlen = std::max(job->XYlen, count * (256 * lanes[i].r + 64));
+		job->units.push_back(U);
+		i += count;
+	}
+	job->total = offset;
+}
+
+/**
+ * run_unit(job, unit, S):
+ * Run the lanes of the unit with scratch S.
+ * Return 0 on success; or -1 if the progress callback asked to stop.
+ */
+static int
+run_unit(const struct lanes_job * job, const struct unit * U, struct scratch * S)
+{
+	const struct lane & L = job->lanes[U->first];
+
+	if (U->paired)
+		return (libscrypt_smix2_avx2(L.B, job->lanes[U->second].B, L.r,
+		    L.N, S->V, S->XY, U->offset, job->total));
+	return (job->smix(L.B, L.r, L.N, S->V, S->XY, U->offset, job->total));
+}
+
+/* State shared by the threads of a parallel run. */
+struct parallel_state {
+	const struct lanes_job * job;
+	std::atomic<size_t> next_unit;
+	std::atomic<uint64_t> done;
+	std::atomic<int> stop;
+	std::mutex mut;
+	std::condition_variable cond;
+	uint32_t running;
+	int error;
+};
+
+/* Progress of one worker thread: smix reports absolute positions in the job. */
+struct worker_progress {
+	struct parallel_state * state;
+	uint64_t last;
+};
+
+static int
+worker_progress_callback(void * arg, uint64_t done, uint64_t total)
+{
+	struct worker_progress * wp = (struct worker_progress *)arg;
+
+	(void)total;
+	wp->state->done += done - wp->last;
+	wp->last = done;
+	return (wp->state->stop.load());
+}
+
+static void
+parallel_worker(struct parallel_state * state)
+{
+	const struct lanes_job * job = state->job;
+	struct worker_progress wp = { state, 0 };
+	struct scratch S;
+	size_t unit;
+	int error = 0;
+
+	if (scratch_alloc(&S, job->Vlen, job->XYlen)) {
+		error = errno;
+		state->stop = 1;
+	} else {
+		libscrypt_set_thread_progress(worker_progress_callback, &wp);
+		while (!state->stop.load() &&
+		    (unit = state->next_unit++) < job->units.size()) {
+			const struct unit & U = job->units[unit];
+			const uint64_t end = unit + 1 < job->units.size() ?
+			    job->units[unit + 1].offset : job->total;
+
+			wp.last = U.offset;
+			if (run_unit(job, &U, &S))
+				break;
+			state->done += end - wp.last;
+		}
+		libscrypt_set_thread_progress(NULL, NULL);
+		scratch_free(&S);
+	}
+
+	std::lock_guard<std::mutex> lock(state->mut);
+	if (error != 0 && state->error == 0)
+		state->error = error;
+	state->running--;
+	state->cond.notify_all();
+}
+
+/**
+ * run_parallel(job, threads):
+ * Run the units of the job on the given number of threads, each with its own
+ * scratch.  The calling thread only reports progress and forwards
+ * cancellation, since the progress callback belongs to it.
+ * Return 0 on success; or -1 on error or cancellation with errno set.
+ */
+static int
+run_parallel(const struct lanes_job * job, uint32_t threads)
+{
+	struct parallel_state state;
+	std::vector<std::thread> workers;
+	uint32_t i;
+
+	state.job = job;
+	state.next_unit = 0;
+	state.done = 0;
+	state.stop = 0;
+	state.running = 0;
+	state.error = 0;
+
+	try {
+		for (i = 0; i < threads; i++) {
+			{
+				std::lock_guard<std::mutex> lock(state.mut);
+				state.running++;
+			}
+			try {
+				workers.emplace_back(parallel_worker, &state);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(state.mut);
+				state.running--;
+				if (i == 0)
+					throw;
+				break;
+			}
+		}
+	} catch (...) {
+		errno = EAGAIN;
+		return (-1);
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(state.mut);
+		while (state.running != 0) {
+			state.cond.wait_for(lock,
+			    std::chrono::milliseconds(PARALLEL_PROGRESS_PERIOD_MS));
+			lock.unlock();
+			if (!state.stop.load() &&
+			    libscrypt_report_progress(state.done.load(), job->total) != 0)
+				state.stop = 1;
+			lock.lock();
+		}
+	}
+	for (std::thread & worker : workers)
+		worker.join();
+
+	if (state.error != 0) {
+		errno = state.error;
+		return (-1);
+	}
+	if (state.stop.load() || state.next_unit.load() < job->units.size()) {
+		errno = ECANCELED;
+		return (-1);
+	}
+	return (0);
+}
+
+/**
+ * run_job(job):
+ * Compute B_i <-- MF(B_i, N) for every lane of the job.  Independent units go
+ * to separate threads while their scratch fits in PARALLEL_MAX_MEMORY.
+ * Return 0 on success; or -1 on error or cancellation with errno set.
+ */
+static int
+run_job(const struct lanes_job * job)
+{
+	struct scratch S;
+	size_t unit;
+	size_t threads;
+
+	threads = forced_threads.load();
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	threads = std::min(job->units.size(), threads);
+	threads = std::min(threads,
+	    std::max(PARALLEL_MAX_MEMORY / std::max(job->Vlen, (size_t)1), (size_t)1));
+
+	if (threads > 1) {
+		if (run_parallel(job, (uint32_t)threads))
+			return (-1);
+	} else {
+		if (scratch_alloc(&S, job->Vlen, job->XYlen))
+			return (-1);
+		for (unit = 0; unit < job->units.size(); unit++) {
+			if (run_unit(job, &job->units[unit], &S)) {
+				scratch_free(&S);
+				errno = ECANCELED;
+				return (-1);
+			}
+		}
+		scratch_free(&S);
+	}
+	libscrypt_report_progress(job->total, job->total);
+	return (0);
+}
+
+/**
+ * check_params(N, r, p, buflen, lanes):
+ * Return 0 if libscrypt_scrypt accepts the parameters; or -1 with errno set.
+ */
+static int
+check_params(uint64_t N, uint32_t r, uint32_t p, size_t buflen, size_t lanes)
+{
+#if SIZE_MAX > UINT32_MAX
+	if (buflen > (((uint64_t)(1) << 32) - 1) * 32) {
+		errno = EFBIG;
+		return (-1);
+	}
+#else
+	(void)buflen;
+#endif
+	if ((uint64_t)(r) * (uint64_t)(p) >= (1 << 30)) {
+		errno = EFBIG;
+		return (-1);
+	}
+	if (r == 0 || p == 0) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if (((N & (N - 1)) != 0) || (N < 2)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if ((r > SIZE_MAX / 128 / p) ||
+#if SIZE_MAX / 256 <= UINT32_MAX
+	    (r > SIZE_MAX / 256) ||
+#endif
+	    (N > SIZE_MAX / 128 / r / lanes)) {
+		errno = ENOMEM;
+		return (-1);
+	}
+	return (0);
+}
+
+static void *
+alloc_blocks(size_t len, uint8_t ** B)
+{
+	void * B0;
+
+#ifdef HAVE_POSIX_MEMALIGN
+	if ((errno = posix_memalign(&B0, 64, len)) != 0)
+		return (NULL);
+	*B = (uint8_t *)(B0);
+#else
+	if ((B0 = malloc(len + 63)) == NULL)
+		return (NULL);
+	*B = (uint8_t *)(((uintptr_t)(B0) + 63) & ~ (uintptr_t)(63));
+#endif
+	return (B0);
+}
+
+/**
+ * crypto_scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen):
+ * Compute scrypt(passwd[0 .. passwdlen - 1], salt[0 .. saltlen - 1], N, r,
+ * p, buflen) and write the result into buf.  The parameters r, p, and buflen
+ * must satisfy r * p < 2^30 and buflen <= (2^32 - 1) * 32.  The parameter N
+ * must be a power of 2 greater than 1.
+ *
+ * Return 0 on success; or -1 on error
+ */
+int
+libscrypt_scrypt(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    uint8_t * buf, size_t buflen)
+{
+	void * B0;
+	uint8_t * B;
+	uint32_t i;
+	const enum libscrypt_kernel kernel = libscrypt_get_kernel();
+
+	/* Sanity-check parameters. */
+	if (check_params(N, r, p, buflen, kernel == LIBSCRYPT_KERNEL_AVX2 ? 2 : 1))
+		goto err0;
+
+	/* Allocate memory. */
+	if ((B0 = alloc_blocks(128 * r * p, &B)) == NULL)
+		goto err0;
+
+	/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
+	libscrypt_PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, 1, B, p * 128 * r);
+
+	/* 2: for i = 0 to p - 1 do */
+	try {
+		struct lanes_job job;
+
+		for (i = 0; i < p; i++)
+			job.lanes.push_back(lane{ &B[i * 128 * r], r, N });
+		job_init(&job, kernel);
+
+		/* 3: B_i <-- MF(B_i, N) */
+		if (run_job(&job))
+			goto err1;
+	} catch (...) {
+		errno = ENOMEM;
+		goto err1;
+	}
+
+	/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
+	libscrypt_PBKDF2_SHA256(passwd, passwdlen, B, p * 128 * r, 1, buf, buflen);
+
+	/* Free memory. */
+	free(B0);
+
+	/* Success! */
+	return (0);
+
+err1:
+	free(B0);
+err0:
+	/* Failure! */
+	return (-1);
+}
+
+int
+libscrypt_scrypt_batch(struct libscrypt_batch_item * items, size_t count)
+{
+	const enum libscrypt_kernel kernel = libscrypt_get_kernel();
+	std::vector<void *> blocks(count, NULL);
+	std::vector<uint8_t *> B(count, NULL);
+	struct lanes_job job;
+	int error = 0;
+	size_t k;
+	uint32_t i;
+
+	try {
+		for (k = 0; k < count; k++) {
+			struct libscrypt_batch_item & item = items[k];
+
+			item.result = 0;
+			if (check_params(item.N, item.r, item.p, item.buflen,
+			    kernel == LIBSCRYPT_KERNEL_AVX2 ? 2 : 1) ||
+			    (blocks[k] = alloc_blocks(128 * item.r * item.p, &B[k])) == NULL) {
+				item.result = errno;
+				continue;
+			}
+
+			/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
+			libscrypt_PBKDF2_SHA256(item.passwd, item.passwdlen,
+			    item.salt, item.saltlen, 1, B[k], item.p * 128 * item.r);
+			for (i = 0; i < item.p; i++)
+				job.lanes.push_back(lane{ &B[k][i * 128 * item.r], item.r, item.N });
+		}
+		job_init(&job, kernel);
+
+		/* 3: B_i <-- MF(B_i, N) for the lanes of all instances */
+		if (!job.lanes.empty() && run_job(&job))
+			error = errno;
+	} catch (...) {
+		error = ENOMEM;
+	}
+
+	for (k = 0; k < count; k++) {
+		struct libscrypt_batch_item & item = items[k];
+
+		if (blocks[k] == NULL)
+			continue;
+		if (error != 0) {
+			item.result = error;
+		} else {
+			/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
+			libscrypt_PBKDF2_SHA256(item.passwd, item.passwdlen,
+			    B[k], item.p * 128 * item.r, 1, item.buf, item.buflen);
+		}
+		free(blocks[k]);
+	}
+
+	for (k = 0; k < count; k++) {
+		if (items[k].result != 0) {
+			errno = items[k].result;
+			return (-1);
+		}
+	}
+	return (0);
+}
@@ -0,0 +1,237 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "crypto_scrypt_smix.h"
+#include "libscrypt.h"
+
+/*
+ * V of libscrypt_scrypt is 128rN bytes (256 MB for ETH keystores).  Mapping
+ * and faulting it in on every call dominates short unlocks and makes RSS jump,
+ * so released regions are kept mapped and already faulted for the next call
+ * until they stay idle for the timeout.  V[0] is PBKDF2-SHA256(P, S, 1), which
+ * would let a reader of process memory check passwords without scrypt, so a
+ * region is wiped on release before it becomes idle.  Only the bytes the call
+ * asked for are wiped, the rest is still zero, and a call never gets a region
+ * more than twice its size, so the wipe stays proportional to the call.
+ */
+
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+/* Called through a volatile pointer so the wipe is not optimized away. */
+static void * (* const volatile memset_ptr)(void *, int, size_t) = memset;
+
+typedef std::chrono::steady_clock arena_clock;
+
+struct region {
+	void * base;
+	size_t mapped;
+	void * ptr;
+	size_t len;
+	/* Bytes the current call asked for; only they can hold its data. */
+	size_t used;
+	int in_use;
+	arena_clock::time_point last_used;
+};
+
+static std::mutex arena_mutex;
+static std::vector<region> regions;
+static size_t max_idle_bytes = (size_t)512 * 1024 * 1024;
+static std::chrono::milliseconds idle_timeout(60 * 1000);
+static int huge_pages = 1;
+
+static int
+region_map(struct region * R, size_t len)
+{
+#ifdef MAP_ANON
+	int flags = MAP_ANON | MAP_PRIVATE;
+	const size_t align = huge_pages ? HUGE_PAGE_SIZE : 64;
+
+	size_t i;
+
+#ifdef MAP_NOCORE
+	flags |= MAP_NOCORE;
+#endif
+	R->mapped = len + align;
+	if ((R->base = mmap(NULL, R->mapped, PROT_READ | PROT_WRITE, flags, -1,
+	    0)) == MAP_FAILED)
+		return (-1);
+	R->ptr = (void *)(((uintptr_t)(R->base) + align - 1) & ~ (uintptr_t)(align - 1));
+#ifdef MADV_HUGEPAGE
+	if (huge_pages)
+		madvise(R->ptr, len, MADV_HUGEPAGE);
+#endif
+	/* Fault the region in now, after madvise, so smix runs on resident pages. */
+	for (i = 0; i < len; i += 4096)
+		((volatile uint8_t *)R->ptr)[i] = 0;
+#else
+	R->mapped = len + 63;
+	if ((R->base = malloc(R->mapped)) == NULL)
+		return (-1);
+	R->ptr = (void *)(((uintptr_t)(R->base) + 63) & ~ (uintptr_t)(63));
+#endif
+	R->len = len;
+	return (0);
+}
+
+static void
+region_unmap(struct region * R)
+{
+#ifdef MAP_ANON
+	munmap(R->base, R->mapped);
+#else
+	free(R->base);
+#endif
+}
+
+/* Unmap idle regions that timed out, and more while idle memory exceeds the limit. */
+static void
+trim_locked(int all)
+{
+	const arena_clock::time_point now = arena_clock::now();
+	size_t idle = 0;
+	size_t i;
+
+	for (i = 0; i < regions.size(); i++) {
+		if (!regions[i].in_use)
+			idle += regions[i].len;
+	}
+	for (i = regions.size(); i-- > 0;) {
+		struct region & R = regions[i];
+
+		if (R.in_use)
+			continue;
+		if (all || idle > max_idle_bytes ||
+		    now - R.last_used >= idle_timeout) {
+			idle -= R.len;
+			region_unmap(&R);
+			regions.erase(regions.begin() + i);
+		}
+	}
+}
+
+void *
+libscrypt_arena_acquire(size_t len)
+{
+	std::lock_guard<std::mutex> lock(arena_mutex);
+	struct region R;
+	size_t best = regions.size();
+	size_t i;
+
+	/*
+	 * Smallest idle region that fits, and at most twice the size asked for:
+	 * a small call must not take a big region, whose pages then sit idle
+	 * for it while big calls map new ones.
+	 */
+	for (i = 0; i < regions.size(); i++) {
+		if (!regions[i].in_use && regions[i].len >= len &&
+		    regions[i].len / 2 <= len &&
+		    (best == regions.size() || regions[i].len < regions[best].len))
+			best = i;
+	}
+	if (best != regions.size()) {
+		regions[best].in_use = 1;
+		regions[best].used = len;
+		return (regions[best].ptr);
+	}
+
+	if (region_map(&R, len)) {
+		/* Give idle memory back and retry once. */
+		trim_locked(1);
+		if (region_map(&R, len)) {
+			errno = ENOMEM;
+			return (NULL);
+		}
+	}
+	R.in_use = 1;
+	R.used = len;
+	R.last_used = arena_clock::now();
+	try {
+		regions.push_back(R);
+	} catch (...) {
+		region_unmap(&R);
+		errno = ENOMEM;
+		return (NULL);
+	}
+	return (R.ptr);
+}
+
+void
+libscrypt_arena_release(void * ptr)
+{
+	size_t len = 0;
+	size_t i;
+
+	/* The region is still in use, so it can be wiped without the lock. */
+	{
+		std::lock_guard<std::mutex> lock(arena_mutex);
+
+		for (i = 0; i < regions.size(); i++) {
+			if (regions[i].ptr == ptr) {
+				len = regions[i].used;
+				break;
+			}
+		}
+	}
+	memset_ptr(ptr, 0, len);
+
+	std::lock_guard<std::mutex> lock(arena_mutex);
+	for (i = 0; i < regions.size(); i++) {
+		if (regions[i].ptr == ptr) {
+			regions[i].in_use = 0;
+			regions[i].last_used = arena_clock::now();
+			break;
+		}
+	}
+	trim_locked(0);
+}
+
+void
+libscrypt_arena_configure(size_t max_idle, uint32_t idle_timeout_ms,
+    int use_huge_pages)
+{
+	std::lock_guard<std::mutex> lock(arena_mutex);
+
+	max_idle_bytes = max_idle;
+	idle_timeout = std::chrono::milliseconds(idle_timeout_ms);
+	huge_pages = use_huge_pages;
+	trim_locked(0);
+}
+
+void
+libscrypt_arena_release_idle(void)
+{
+	std::lock_guard<std::mutex> lock(arena_mutex);
+
+	trim_locked(0);
+}
+
+void
+libscrypt_arena_release_all(void)
+{
+	std::lock_guard<std::mutex> lock(arena_mutex);
+
+	trim_locked(1);
+}
+
+size_t
+libscrypt_arena_idle_bytes(void)
+{
+	std::lock_guard<std::mutex> lock(arena_mutex);
+	size_t idle = 0;
+	size_t i;
+
+	for (i = 0; i < regions.size(); i++) {
+		if (!regions[i].in_use)
+			idle += regions[i].len;
+	}
+	return (idle);
+}
@@ -0,0 +1,61 @@
+/*
+ * Internal interface between the libscrypt_scrypt driver and the SMix kernels.
+ */
+#ifndef _CRYPTO_SCRYPT_SMIX_H_
+#define _CRYPTO_SCRYPT_SMIX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* How many smix iterations pass between progress callback calls. */
+#define PROGRESS_INTERVAL 1024
+
+/**
+ * libscrypt_report_progress(done, total):
+ * Call the progress callback of the current thread, if any.  Return non-zero
+ * if the computation must stop.
+ */
+int libscrypt_report_progress(uint64_t done, uint64_t total);
+
+/**
+ * smix(B, r, N, V, XY, progress_done, progress_total):
+ * Compute B = SMix_r(B, N).  The input B must be 128r bytes in length;
+ * the temporary storage V must be 128rN bytes in length; the temporary
+ * storage XY must be 256r + 64 bytes in length.  The value N must be a
+ * power of 2 greater than 1.  The arrays B, V, and XY must be aligned to a
+ * multiple of 64 bytes.  Progress is reported as progress_done plus the
+ * iterations done here, out of progress_total.
+ * Return 0 on success; or -1 if the progress callback asked to stop.
+ */
+typedef int (*libscrypt_smix_func)(uint8_t *, size_t, uint64_t, void *, void *,
+    uint64_t, uint64_t);
+
+int libscrypt_smix_nosse(uint8_t *, size_t, uint64_t, void *, void *,
+    uint64_t, uint64_t);
+
+int libscrypt_smix_sse2(uint8_t *, size_t, uint64_t, void *, void *,
+    uint64_t, uint64_t);
+
+/**
+ * libscrypt_smix2_avx2(B0, B1, r, N, V, XY, progress_done, progress_total):
+ * Compute two independent SMix_r in the two 128-bit halves of the AVX2
+ * registers.  V must be 2 * 128rN bytes and XY 512r + 128 bytes in length,
+ * both aligned to 64 bytes.  Progress counts the iterations of both lanes.
+ */
+int libscrypt_smix2_avx2(uint8_t *, uint8_t *, size_t, uint64_t, void *,
+    void *, uint64_t, uint64_t);
+
+/**
+ * libscrypt_arena_acquire(len):
+ * Return a region of len bytes aligned to 64 bytes for V, reusing an idle one
+ * if it fits; or NULL with errno set.
+ */
+void * libscrypt_arena_acquire(size_t len);
+
+/**
+ * libscrypt_arena_release(ptr):
+ * Wipe a region from libscrypt_arena_acquire and give it back to the arena.
+ */
+void libscrypt_arena_release(void * ptr);
+
+#endif /* !_CRYPTO_SCRYPT_SMIX_H_ */
@@ -29,6 +29,87 @@ extern "C"{
 int libscrypt_scrypt(const uint8_t *, size_t, const uint8_t *, size_t, uint64_t,
     uint32_t, uint32_t, /*@out@*/ uint8_t *, size_t);
 
+/* One scrypt instance of libscrypt_scrypt_batch. result is set to 0 on
+ * success or to the errno of the failure.
+ */
+struct libscrypt_batch_item {
+	const uint8_t * passwd;
+	size_t passwdlen;
+	const uint8_t * salt;
+	size_t saltlen;
+	uint64_t N;
+	uint32_t r;
+	uint32_t p;
+	uint8_t * buf;
+	size_t buflen;
+	int result;
+};
+
+/**
+ * libscrypt_scrypt_batch(items, count):
+ * Compute libscrypt_scrypt for every item. The SMix lanes of all items are
+ * run together: lanes with equal N and r share the AVX2 registers and
+ * independent lanes run on parallel threads. Progress and cancellation work
+ * as for libscrypt_scrypt over the lanes of all items.
+ * Return 0 if every item succeeded; or -1 with errno of the first failed item.
+ */
+int libscrypt_scrypt_batch(struct libscrypt_batch_item * items, size_t count);
+
+/**
+ * Progress callback of libscrypt_scrypt. done and total are counted in smix
+ * iterations over all p lanes. A non-zero return value stops the computation:
+ * libscrypt_scrypt then returns -1 with errno set to ECANCELED.
+ */
+typedef int (*libscrypt_progress_callback)(void * arg, uint64_t done, uint64_t total);
+
+/* Sets the progress callback for libscrypt_scrypt calls made by the current
+ * thread. Pass NULL to remove it.
+ */
+void libscrypt_set_thread_progress(libscrypt_progress_callback callback, void * arg);
+
+/* SMix implementations of libscrypt_scrypt. AUTO picks the fastest one the
+ * CPU supports: AVX2 (two p lanes at once, SSE2 for a single lane), then SSE2,
+ * then the portable code.
+ */
+enum libscrypt_kernel {
+	LIBSCRYPT_KERNEL_AUTO = 0,
+	LIBSCRYPT_KERNEL_NOSSE = 1,
+	LIBSCRYPT_KERNEL_SSE2 = 2,
+	LIBSCRYPT_KERNEL_AVX2 = 3
+};
+
+/* Forces the kernel for all threads; meant for tests and benchmarks.
+ * Return 0 on success; or -1 with errno set to ENOTSUP if the CPU lacks it.
+ */
+int libscrypt_set_kernel(enum libscrypt_kernel kernel);
+
+/* Caps the threads that run p lanes in parallel for all calls; 0 means one per
+ * core. Meant for tests and benchmarks. Units and memory still limit it.
+ */
+void libscrypt_set_threads(uint32_t threads);
+
+/* Returns the kernel libscrypt_scrypt uses now. */
+enum libscrypt_kernel libscrypt_get_kernel(void);
+
+/* V of libscrypt_scrypt comes from an arena of mapped regions. A released
+ * region stays mapped and faulted in for later calls until it is idle for
+ * idle_timeout_ms, or while idle regions exceed max_idle bytes. Regions are
+ * wiped when released, so idle ones hold no password-derived data. huge_pages asks
+ * for transparent huge pages where the OS has them. Defaults: 512 MB, 60 s,
+ * huge pages on.
+ */
+void libscrypt_arena_configure(size_t max_idle, uint32_t idle_timeout_ms,
+    int huge_pages);
+
+/* Unmaps regions idle for longer than the timeout. Call it periodically. */
+void libscrypt_arena_release_idle(void);
+
+/* Unmaps all idle regions. */
+void libscrypt_arena_release_all(void);
+
+/* Returns the size of the idle regions kept by the arena. */
+size_t libscrypt_arena_idle_bytes(void);
+
 /* Converts a series of input parameters to a MCF form for storage */
 int libscrypt_mcf(uint32_t N, uint32_t r, uint32_t p, const char *salt,
 	const char *hash, char *mcf);
@@ -0,0 +1,228 @@
+/*
+ * SHA-256 block functions for x86: one hash at a time with the SHA
+ * extensions, and eight independent hashes at a time with AVX2.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cpufeatures.h"
+
+#include "sha256_blocks.h"
+
+#ifdef LIBSCRYPT_X86_SIMD
+
+#include <immintrin.h>
+
+static const uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Four rounds; M holds W[t..t+3]. */
+#define SHANI_ROUNDS(M, t) do {						\
+	msg = _mm_add_epi32(M, _mm_loadu_si128((const __m128i *)&K[t]));	\
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);		\
+	msg = _mm_shuffle_epi32(msg, 0x0E);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg);		\
+} while (0)
+
+/* Replace the oldest four words M0 by the next four of the schedule. */
+#define SHANI_SCHEDULE(M0, M1, M2, M3) do {				\
+	M0 = _mm_sha256msg1_epu32(M0, M1);				\
+	M0 = _mm_add_epi32(M0, _mm_alignr_epi8(M3, M2, 4));		\
+	M0 = _mm_sha256msg2_epu32(M0, M3);				\
+} while (0)
+
+#define SHANI_SCHEDULE_ROUNDS16(t) do {					\
+	SHANI_SCHEDULE(m0, m1, m2, m3);					\
+	SHANI_ROUNDS(m0, t);						\
+	SHANI_SCHEDULE(m1, m2, m3, m0);					\
+	SHANI_ROUNDS(m1, t + 4);					\
+	SHANI_SCHEDULE(m2, m3, m0, m1);					\
+	SHANI_ROUNDS(m2, t + 8);					\
+	SHANI_SCHEDULE(m3, m0, m1, m2);					\
+	SHANI_ROUNDS(m3, t + 12);					\
+} while (0)
+
+LIBSCRYPT_TARGET_SHA void
+libscrypt_SHA256_blocks_shani(uint32_t state[8], const unsigned char * data,
+    size_t nblocks)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+	    0x0405060700010203ULL);
+	__m128i state0, state1, save0, save1, msg, tmp;
+	__m128i m0, m1, m2, m3;
+
+	/* The rounds instruction keeps the state as ABEF and CDGH. */
+	tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+	state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xB1);
+	state1 = _mm_shuffle_epi32(state1, 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		save0 = state0;
+		save1 = state1;
+
+		m0 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(data + 0)), bswap);
+		m1 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+		m2 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+		m3 = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+		SHANI_ROUNDS(m0, 0);
+		SHANI_ROUNDS(m1, 4);
+		SHANI_ROUNDS(m2, 8);
+		SHANI_ROUNDS(m3, 12);
+		SHANI_SCHEDULE_ROUNDS16(16);
+		SHANI_SCHEDULE_ROUNDS16(32);
+		SHANI_SCHEDULE_ROUNDS16(48);
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+	}
+
+	/* Back to ABCD and EFGH. */
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *)&state[0], state0);
+	_mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+#define ROTR8(x, n)	_mm256_or_si256(_mm256_srli_epi32(x, n),	\
+			    _mm256_slli_epi32(x, 32 - (n)))
+#define ADD8(x, y)	_mm256_add_epi32(x, y)
+#define XOR8(x, y)	_mm256_xor_si256(x, y)
+#define Ch8(x, y, z)	XOR8(_mm256_and_si256(x, XOR8(y, z)), z)
+#define Maj8(x, y, z)	_mm256_or_si256(_mm256_and_si256(x,		\
+			    _mm256_or_si256(y, z)), _mm256_and_si256(y, z))
+#define S08(x)		XOR8(XOR8(ROTR8(x, 2), ROTR8(x, 13)), ROTR8(x, 22))
+#define S18(x)		XOR8(XOR8(ROTR8(x, 6), ROTR8(x, 11)), ROTR8(x, 25))
+#define s08(x)		XOR8(XOR8(ROTR8(x, 7), ROTR8(x, 18)),		\
+			    _mm256_srli_epi32(x, 3))
+#define s18(x)		XOR8(XOR8(ROTR8(x, 17), ROTR8(x, 19)),		\
+			    _mm256_srli_epi32(x, 10))
+
+/* Transpose an 8x8 matrix of 32-bit words held in eight registers. */
+static LIBSCRYPT_TARGET_AVX2 void
+transpose8(__m256i r[8])
+{
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+	__m256i u0, u1, u2, u3, u4, u5, u6, u7;
+
+	t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+	t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+	t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+	t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+	t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+	t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+	t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+	t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+	u0 = _mm256_unpacklo_epi64(t0, t2);
+	u1 = _mm256_unpackhi_epi64(t0, t2);
+	u2 = _mm256_unpacklo_epi64(t1, t3);
+	u3 = _mm256_unpackhi_epi64(t1, t3);
+	u4 = _mm256_unpacklo_epi64(t4, t6);
+	u5 = _mm256_unpackhi_epi64(t4, t6);
+	u6 = _mm256_unpacklo_epi64(t5, t7);
+	u7 = _mm256_unpackhi_epi64(t5, t7);
+
+	r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+	r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+	r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+	r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+	r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+	r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+	r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+	r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+LIBSCRYPT_TARGET_AVX2 void
+libscrypt_SHA256_x8_avx2(uint32_t * const state[8],
+    const unsigned char * const block[8])
+{
+	const __m256i bswap = _mm256_set_epi8(
+	    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+	    12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	__m256i S[8], W[16];
+	__m256i a, b, c, d, e, f, g, h, t0, t1;
+	int i, t;
+
+	/* Row i of the loads is hash i; after the transpose word j is S[j]. */
+	for (i = 0; i < 8; i++) {
+		S[i] = _mm256_loadu_si256((const __m256i *)state[i]);
+		W[i] = _mm256_loadu_si256((const __m256i *)block[i]);
+		W[i + 8] = _mm256_loadu_si256((const __m256i *)(block[i] + 32));
+	}
+	transpose8(S);
+	transpose8(W);
+	transpose8(W + 8);
+	for (i = 0; i < 16; i++)
+		W[i] = _mm256_shuffle_epi8(W[i], bswap);
+
+	a = S[0];
+	b = S[1];
+	c = S[2];
+	d = S[3];
+	e = S[4];
+	f = S[5];
+	g = S[6];
+	h = S[7];
+
+	for (t = 0; t < 64; t++) {
+		if (t >= 16)
+			W[t & 15] = ADD8(ADD8(s18(W[(t - 2) & 15]),
+			    W[(t - 7) & 15]), ADD8(s08(W[(t - 15) & 15]),
+			    W[t & 15]));
+		t0 = ADD8(ADD8(h, S18(e)), ADD8(Ch8(e, f, g),
+		    ADD8(_mm256_set1_epi32((int)K[t]), W[t & 15])));
+		t1 = ADD8(S08(a), Maj8(a, b, c));
+		h = g;
+		g = f;
+		f = e;
+		e = ADD8(d, t0);
+		d = c;
+		c = b;
+		b = a;
+		a = ADD8(t0, t1);
+	}
+
+	S[0] = ADD8(S[0], a);
+	S[1] = ADD8(S[1], b);
+	S[2] = ADD8(S[2], c);
+	S[3] = ADD8(S[3], d);
+	S[4] = ADD8(S[4], e);
+	S[5] = ADD8(S[5], f);
+	S[6] = ADD8(S[6], g);
+	S[7] = ADD8(S[7], h);
+	transpose8(S);
+	for (i = 0; i < 8; i++)
+		_mm256_storeu_si256((__m256i *)state[i], S[i]);
+
+	/* Clean the stack. */
+	memset(W, 0, sizeof(W));
+}
+
+#endif /* LIBSCRYPT_X86_SIMD */
@@ -29,9 +29,14 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "cpufeatures.h"
 #include "sysendian.h"
 
 #include "sha256.h"
+#include "sha256_blocks.h"
+
+/* Number of PBKDF2 output blocks computed together. */
+#define PBKDF2_LANES 8
 
 /*
  * Encode a length len/4 vector of (uint32_t) into a length len vector of
@@ -180,6 +185,68 @@ SHA256_Transform(uint32_t * state, const unsigned char block[64])
 	t0 = t1 = 0;
 }
 
+/* Compress nblocks consecutive blocks one by one. */
+static void
+SHA256_Blocks(uint32_t * state, const unsigned char * data, size_t nblocks)
+{
+
+	for (; nblocks > 0; nblocks--, data += 64)
+		SHA256_Transform(state, data);
+}
+
+static libscrypt_sha256_blocks_func
+select_blocks(void)
+{
+
+#ifdef LIBSCRYPT_X86_SIMD
+	if (libscrypt_cpu_features() & LIBSCRYPT_CPU_SHA)
+		return (libscrypt_SHA256_blocks_shani);
+#endif
+	return (SHA256_Blocks);
+}
+
+/* Compress nblocks blocks with the fastest block function of the CPU. */
+static void
+SHA256_Blocks_dispatch(uint32_t * state, const unsigned char * data,
+    size_t nblocks)
+{
+	static const libscrypt_sha256_blocks_func blocks = select_blocks();
+
+	blocks(state, data, nblocks);
+}
+
+/*
+ * Compress block[i] into state[i] for n independent hashes.  Without the
+ * SHA extensions AVX2 runs eight of them at once; a lone hash is cheaper on
+ * the scalar path than padded out to eight lanes.
+ */
+static void
+SHA256_Transform_lanes(uint32_t * const * state,
+    const unsigned char * const * block, size_t n)
+{
+	size_t i = 0;
+#ifdef LIBSCRYPT_X86_SIMD
+	uint32_t * st[8];
+	const unsigned char * bl[8];
+	uint32_t spare[8];
+	size_t k;
+
+	if ((libscrypt_cpu_features() & (LIBSCRYPT_CPU_AVX2 |
+	    LIBSCRYPT_CPU_SHA)) == LIBSCRYPT_CPU_AVX2) {
+		for (; i + 1 < n; i += 8) {
+			/* Unused lanes hash the first block into a spare state. */
+			for (k = 0; k < 8; k++) {
+				st[k] = (i + k < n) ? state[i + k] : spare;
+				bl[k] = (i + k < n) ? block[i + k] : block[i];
+			}
+			libscrypt_SHA256_x8_avx2(st, bl);
+		}
+	}
+#endif
+	for (; i < n; i++)
+		SHA256_Blocks_dispatch(state[i], block[i], 1);
+}
+
 static unsigned char PAD[64] = {
 	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -256,15 +323,15 @@ libscrypt_SHA256_Update(SHA256_CTX * ctx, const void *in, size_t len)
 
 	/* Finish the current block */
 	memcpy(&ctx->buf[r], src, 64 - r);
-	SHA256_Transform(ctx->state, ctx->buf);
+	SHA256_Blocks_dispatch(ctx->state, ctx->buf, 1);
 	src += 64 - r;
 	len -= 64 - r;
 
 	/* Perform complete blocks */
-	while (len >= 64) {
-		SHA256_Transform(ctx->state, src);
-		src += 64;
-		len -= 64;
+	if (len >= 64) {
+		SHA256_Blocks_dispatch(ctx->state, src, len / 64);
+		src += len & ~(size_t)63;
+		len &= 63;
 	}
 
 	/* Copy left over data into buffer */
@@ -289,6 +356,98 @@ libscrypt_SHA256_Final(unsigned char digest[32], SHA256_CTX * ctx)
 	memset((void *)ctx, 0, sizeof(*ctx));
 }
 
+/* Compute the SHA-256 hash of len bytes of in. */
+void
+libscrypt_SHA256(const void * in, size_t len, unsigned char digest[32])
+{
+	SHA256_CTX ctx;
+
+	libscrypt_SHA256_Init(&ctx);
+	libscrypt_SHA256_Update(&ctx, in, len);
+	libscrypt_SHA256_Final(digest, &ctx);
+}
+
+/* Compute SHA256(SHA256(in)). */
+void
+libscrypt_SHA256d(const void * in, size_t len, unsigned char digest[32])
+{
+	unsigned char hash[32];
+
+	libscrypt_SHA256(in, len, hash);
+	libscrypt_SHA256(hash, 32, digest);
+	memset(hash, 0, 32);
+}
+
+/* Pad a message of at most 55 bytes into a single final block. */
+static void
+SHA256_Pad_block(unsigned char block[64], const unsigned char * in, size_t len)
+{
+	uint64_t bits = (uint64_t)len << 3;
+	int i;
+
+	if (block != in)
+		memcpy(block, in, len);
+	memset(block + len, 0, 64 - len);
+	block[len] = 0x80;
+	for (i = 0; i < 8; i++)
+		block[63 - i] = (unsigned char)(bits >> (8 * i));
+}
+
+/*
+ * Compute SHA256(SHA256(in[i])) for n messages.  Messages of at most 55
+ * bytes (Base58Check payloads, for one) take one block each and are
+ * compressed together through SHA256_Transform_lanes; longer messages are
+ * hashed one by one.
+ */
+void
+libscrypt_SHA256d_batch(const unsigned char * const * in, const size_t * len,
+    size_t n, unsigned char (* digest)[32])
+{
+	SHA256_CTX init;
+	unsigned char blocks[8][64];
+	uint32_t states[8][8];
+	uint32_t * st[8];
+	const unsigned char * bl[8];
+	size_t idx[8];
+	size_t i, k, m;
+
+	libscrypt_SHA256_Init(&init);
+	for (k = 0; k < 8; k++) {
+		st[k] = states[k];
+		bl[k] = blocks[k];
+	}
+
+	for (i = 0; i < n; ) {
+		/* Gather up to eight single-block messages. */
+		for (m = 0; m < 8 && i < n; i++) {
+			if (len[i] > 55) {
+				libscrypt_SHA256d(in[i], len[i], digest[i]);
+				continue;
+			}
+			SHA256_Pad_block(blocks[m], in[i], len[i]);
+			memcpy(states[m], init.state, 32);
+			idx[m++] = i;
+		}
+		if (m == 0)
+			continue;
+		SHA256_Transform_lanes(st, bl, m);
+
+		/* The second hash is over the 32-byte first digest. */
+		for (k = 0; k < m; k++) {
+			be32enc_vect(blocks[k], states[k], 32);
+			SHA256_Pad_block(blocks[k], blocks[k], 32);
+			memcpy(states[k], init.state, 32);
+		}
+		SHA256_Transform_lanes(st, bl, m);
+		for (k = 0; k < m; k++)
+			be32enc_vect(digest[idx[k]], states[k], 32);
+	}
+
+	/* Clean the stack. */
+	memset(blocks, 0, sizeof(blocks));
+	memset(states, 0, sizeof(states));
+}
+
 /* Initialize an HMAC-SHA256 operation with the given key. */
 void
 libscrypt_HMAC_SHA256_Init(HMAC_SHA256_CTX * ctx, const void * _K, size_t Klen)
@@ -353,59 +512,135 @@ libscrypt_HMAC_SHA256_Final(unsigned char digest[32], HMAC_SHA256_CTX * ctx)
 	memset(ihash, 0, 32);
 }
 
+/*
+ * Set state[l] to init, compress the padded 32-byte message in U[l] and
+ * write the digest over the message, for n lanes.  U[l] must hold the
+ * padding for a 96-byte message (a key block and a digest) after byte 32.
+ */
+static void
+HMAC_SHA256_Step_lanes(const uint32_t init[8], uint32_t (*S)[8],
+    unsigned char (*U)[64], size_t n)
+{
+	uint32_t * Sp[PBKDF2_LANES] = {};
+	const unsigned char * Up[PBKDF2_LANES] = {};
+	size_t l;
+
+	for (l = 0; l < n; l++) {
+		memcpy(S[l], init, 32);
+		Sp[l] = S[l];
+		Up[l] = U[l];
+	}
+	SHA256_Transform_lanes(Sp, Up, n);
+	for (l = 0; l < n; l++)
+		be32enc_vect(U[l], S[l], 32);
+}
+
 /**
  * PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, c, buf, dkLen):
  * Compute PBKDF2(passwd, salt, c, dkLen) using HMAC-SHA256 as the PRF, and
  * write the output to buf.  The value dkLen must be at most 32 * (2^32 - 1).
+ *
+ * Up to PBKDF2_LANES output blocks are computed together, so that each
+ * compression runs over several independent blocks at once.
  */
 void
 libscrypt_PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
     size_t saltlen, uint64_t c, uint8_t * buf, size_t dkLen)
 {
-	HMAC_SHA256_CTX PShctx, hctx;
-	size_t i;
-	uint8_t ivec[4];
-	uint8_t U[32];
-	uint8_t T[32];
+	HMAC_SHA256_CTX PShctx;
+	uint32_t istate[8], ostate[8];
+	uint32_t S[PBKDF2_LANES][8];
+	uint32_t * Sp[PBKDF2_LANES];
+	const unsigned char * Bp[PBKDF2_LANES];
+	unsigned char tail[PBKDF2_LANES][128];
+	unsigned char U[PBKDF2_LANES][64];
+	uint8_t T[PBKDF2_LANES][32];
+	uint64_t bitlen;
+	size_t i, l, n, r, tlen;
+	size_t clen;
 	uint64_t j;
 	int k;
-	size_t clen;
 
 	/* Compute HMAC state after processing P and S. */
 	libscrypt_HMAC_SHA256_Init(&PShctx, passwd, passwdlen);
+	memcpy(istate, PShctx.ictx.state, 32);
+	memcpy(ostate, PShctx.octx.state, 32);
 	libscrypt_HMAC_SHA256_Update(&PShctx, salt, saltlen);
 
-	/* Iterate through the blocks. */
-	for (i = 0; i * 32 < dkLen; i++) {
-		/* Generate INT(i + 1). */
-		be32enc(ivec, (uint32_t)(i + 1));
+	/*
+	 * The inner hash of U_1 ends with the buffered bytes of S, INT(i) and
+	 * the padding: one or two blocks which differ only in INT(i).
+	 */
+	r = (PShctx.ictx.count[1] >> 3) & 0x3f;
+	tlen = (r + 4 + 9 <= 64) ? 64 : 128;
+	bitlen = (((uint64_t)PShctx.ictx.count[0] << 32) |
+	    PShctx.ictx.count[1]) + 32;
+	for (l = 0; l < PBKDF2_LANES; l++) {
+		memset(tail[l], 0, tlen);
+		memcpy(tail[l], PShctx.ictx.buf, r);
+		tail[l][r + 4] = 0x80;
+		be32enc(&tail[l][tlen - 8], (uint32_t)(bitlen >> 32));
+		be32enc(&tail[l][tlen - 4], (uint32_t)bitlen);
+
+		/* The other hashes all take a key block and a 32-byte digest. */
+		memset(U[l], 0, 64);
+		U[l][32] = 0x80;
+		be32enc(&U[l][60], (64 + 32) * 8);
+	}
+
+	/* Iterate through the blocks, PBKDF2_LANES at a time. */
+	for (i = 0; i * 32 < dkLen; i += n) {
+		n = (dkLen - i * 32 + 31) / 32;
+		if (n > PBKDF2_LANES)
+			n = PBKDF2_LANES;
 
 		/* Compute U_1 = PRF(P, S || INT(i)). */
-		memcpy(&hctx, &PShctx, sizeof(HMAC_SHA256_CTX));
-		libscrypt_HMAC_SHA256_Update(&hctx, ivec, 4);
-		libscrypt_HMAC_SHA256_Final(U, &hctx);
+		for (l = 0; l < n; l++) {
+			be32enc(&tail[l][r], (uint32_t)(i + l + 1));
+			memcpy(S[l], PShctx.ictx.state, 32);
+			Sp[l] = S[l];
+			Bp[l] = tail[l];
+		}
+		SHA256_Transform_lanes(Sp, Bp, n);
+		if (tlen == 128) {
+			for (l = 0; l < n; l++)
+				Bp[l] = tail[l] + 64;
+			SHA256_Transform_lanes(Sp, Bp, n);
+		}
+		for (l = 0; l < n; l++)
+			be32enc_vect(U[l], S[l], 32);
+		HMAC_SHA256_Step_lanes(ostate, S, U, n);
 
 		/* T_i = U_1 ... */
-		memcpy(T, U, 32);
+		for (l = 0; l < n; l++)
+			memcpy(T[l], U[l], 32);
 
 		for (j = 2; j <= c; j++) {
 			/* Compute U_j. */
-			libscrypt_HMAC_SHA256_Init(&hctx, passwd, passwdlen);
-			libscrypt_HMAC_SHA256_Update(&hctx, U, 32);
-			libscrypt_HMAC_SHA256_Final(U, &hctx);
+			HMAC_SHA256_Step_lanes(istate, S, U, n);
+			HMAC_SHA256_Step_lanes(ostate, S, U, n);
 
 			/* ... xor U_j ... */
-			for (k = 0; k < 32; k++)
-				T[k] ^= U[k];
+			for (l = 0; l < n; l++)
+				for (k = 0; k < 32; k++)
+					T[l][k] ^= U[l][k];
 		}
 
 		/* Copy as many bytes as necessary into buf. */
-		clen = dkLen - i * 32;
-		if (clen > 32)
-			clen = 32;
-		memcpy(&buf[i * 32], T, clen);
+		for (l = 0; l < n; l++) {
+			clen = dkLen - (i + l) * 32;
+			if (clen > 32)
+				clen = 32;
+			memcpy(&buf[(i + l) * 32], T[l], clen);
+		}
 	}
 
-	/* Clean PShctx, since we never called _Final on it. */
+	/* Clean PShctx, since we never called _Final on it, and the stack. */
 	memset(&PShctx, 0, sizeof(HMAC_SHA256_CTX));
+	memset(istate, 0, 32);
+	memset(ostate, 0, 32);
+	memset(S, 0, sizeof(S));
+	memset(tail, 0, sizeof(tail));
+	memset(U, 0, sizeof(U));
+	memset(T, 0, sizeof(T));
 }
@@ -33,6 +33,8 @@
 
 #include <stdint.h>
 
+#define SHA256_DIGEST_SIZE 32
+
 typedef struct libscrypt_SHA256Context {
 	uint32_t state[8];
 	uint32_t count[2];
@@ -51,6 +53,29 @@ void	libscrypt_SHA256_Update(SHA256_CTX *, const void *, size_t);
  *	void    SHA256_Final(unsigned char [32], SHA256_CTX *);
 */
 void	libscrypt_SHA256_Final(/*@out@*/ unsigned char [], SHA256_CTX *);
+
+/**
+ * libscrypt_SHA256(in, len, digest):
+ * Compute the SHA-256 hash of len bytes of in.  All hashing here uses the SHA
+ * extensions of the CPU when it has them.
+ */
+void	libscrypt_SHA256(const void *, size_t, unsigned char [32]);
+
+/**
+ * libscrypt_SHA256d(in, len, digest):
+ * Compute SHA256(SHA256(in)), the hash of Bitcoin transactions and
+ * address checksums.
+ */
+void	libscrypt_SHA256d(const void *, size_t, unsigned char [32]);
+
+/**
+ * libscrypt_SHA256d_batch(in, len, n, digest):
+ * Compute digest[i] = SHA256d(in[i], len[i]) for n messages.  Short messages
+ * are hashed several at a time when the CPU has AVX2 but no SHA extensions.
+ */
+void	libscrypt_SHA256d_batch(const unsigned char * const *, const size_t *,
+    size_t, unsigned char (*)[32]);
+
 void	libscrypt_HMAC_SHA256_Init(HMAC_SHA256_CTX *, const void *, size_t);
 void	libscrypt_HMAC_SHA256_Update(HMAC_SHA256_CTX *, const void *, size_t);
 
@@ -0,0 +1,27 @@
+/*
+ * Internal interface between the SHA-256 code and its SIMD block functions.
+ */
+#ifndef _SHA256_BLOCKS_H_
+#define _SHA256_BLOCKS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * blocks(state, data, nblocks):
+ * Compress nblocks consecutive 64-byte blocks of data into state.
+ */
+typedef void (*libscrypt_sha256_blocks_func)(uint32_t [8],
+    const unsigned char *, size_t);
+
+void libscrypt_SHA256_blocks_shani(uint32_t [8], const unsigned char *, size_t);
+
+/**
+ * libscrypt_SHA256_x8_avx2(state, block):
+ * Compress block[i] into state[i] for eight independent hashes at once, one
+ * per 32-bit lane of the AVX2 registers.
+ */
+void libscrypt_SHA256_x8_avx2(uint32_t * const [8],
+    const unsigned char * const [8]);
+
+#endif /* !_SHA256_BLOCKS_H_ */
@@ -0,0 +1,94 @@
+#include "secp256k1ctx.h"
+
+#include <mutex>
+#include <vector>
+
+#include <cryptopp/osrng.h>
+
+#include "check.h"
+
+//Через столько обращений к контексту потока его ослепление обновляется
+const static size_t RANDOMIZE_PERIOD = 1024;
+
+static void RandomizeContext(secp256k1_context* ctx) {
+    CryptoPP::AutoSeededRandomPool prng;
+    unsigned char seed[32];
+    prng.GenerateBlock(seed, sizeof(seed));
+    CHECK(secp256k1_context_randomize(ctx, seed), "secp256k1_context_randomize error");
+}
+
+//Свободные контексты. Таблицы считаются один раз для образца, новые контексты - его копии
+class ContextPool {
+public:
+
+    ContextPool()
+        : prototype(secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY))
+    {}
+
+    secp256k1_context* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeContexts.empty()) {
+            secp256k1_context* ctx = freeContexts.back();
+            freeContexts.pop_back();
+            return ctx;
+        }
+        return secp256k1_context_clone(prototype);
+    }
+
+    void release(secp256k1_context* ctx) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeContexts.push_back(ctx);
+    }
+
+private:
+
+    secp256k1_context* const prototype;
+
+    std::mutex mutex;
+
+    std::vector<secp256k1_context*> freeContexts;
+};
+
+//Пул и контексты не удаляются: потоки могут завершаться уже после статических деструкторов
+static ContextPool& getPool() {
+    static ContextPool* pool = new ContextPool();
+    return *pool;
+}
+
+class ThreadContext {
+public:
+
+    ThreadContext()
+        : ctx(getPool().acquire())
+    {
+        try {
+            RandomizeContext(ctx);
+        } catch (...) {
+            getPool().release(ctx);
+            throw;
+        }
+    }
+
+    ~ThreadContext() {
+        getPool().release(ctx);
+    }
+
+    secp256k1_context* get() {
+        uses++;
+        if (uses % RANDOMIZE_PERIOD == 0) {
+            RandomizeContext(ctx);
+        }
+        return ctx;
+    }
+
+private:
+
+    secp256k1_context* const ctx;
+
+    size_t uses = 0;
+};
+
+secp256k1_context const* getCtx() {
+    static thread_local ThreadContext context;
+    return context.get();
+}
@@ -0,0 +1,12 @@
+#ifndef ETHTX_SECP256K1CTX
+#define ETHTX_SECP256K1CTX
+
+#include <secp256k1/include/secp256k1.h>
+
+//Контекст secp256k1 для подписи и проверки, закрепленный за текущим потоком.
+//Контексты берутся из общего пула и возвращаются в него при завершении потока,
+//таблицы считаются один раз. Ослепление обновляется при выдаче контекста потоку
+//и периодически по мере использования
+secp256k1_context const* getCtx();
+
+#endif
@@ -3,6 +3,7 @@
 #include "utils2.h"
 #include "rlp.h"
 #include "const.h"
+#include "hex.h"
 
 #include <cstring>
 
@@ -10,14 +11,8 @@
 
 std::string DumpToHexString(const uint8_t* dump, uint32_t dumpsize)
 {
-    std::string res;
-    const char hex[] = "0123456789abcdef";
-    for (size_t i = 0; i < dumpsize; ++i)
-    {
-        unsigned char c = static_cast<unsigned char>(dump[i]);
-        res += hex[c >> 4];
-        res += hex[c & 0xf];
-    }
+    std::string res(HexEncodedSize(dumpsize), '\0');
+    HexEncode(dump, dumpsize, &res[0]);
     return res;
 }
 
@@ -28,40 +23,8 @@ std::string DumpToHexString(const std::string &str)
 
 std::string HexStringToDump(const std::string& hexstr)
 {
-    std::string decoded = "";
-    unsigned char a,b,c;
-    a = b = c = 0;
-
-    for (int cnt = (int)hexstr.size()-1; cnt >= 0;)
-    {
-        a = hexstr.at(cnt);
-        --cnt;
-        b = (cnt >= 0) ? hexstr.at(cnt) : '0';
-        --cnt;
-        if (a >= '0' && a <= '9') {
-            a = a - '0';
-        } else if (a >= 'a' && a <= 'f') {
-            a = a - 'a' + 10;
-        } else if (a >= 'A' && a <= 'F') {
-            a = a - 'A' + 10;
-        } else {
-            throwErr("Incorrect hex str " + hexstr);
-        }
-
-        if (b >= '0' && b <= '9') {
-            b = b - '0';
-        } else if (b >= 'a' && b <= 'f') {
-            b = b - 'a' + 10;
-        } else if (b >= 'A' && b <= 'F') {
-            b = b - 'A' + 10;
-        } else {
-            throwErr("Incorrect hex str " + hexstr);
-        }
-
-        c = (b << 4) + a;
-        decoded.insert(decoded.begin(), c);
-    }
-
+    std::string decoded(HexDecodedSize(hexstr.size()), '\0');
+    CHECK(HexDecode(hexstr.data(), hexstr.size(), (uint8_t*)&decoded[0]), "Incorrect hex str " + hexstr);
     return decoded;
 }
 
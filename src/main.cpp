@@ -35,6 +35,8 @@ static void crash_handler(int sig) {
 }
 #endif
 
+const static size_t RSA_KEYS_POOL_SIZE = 2;
+
 int main(int argc, char *argv[]) {
 #ifndef _WIN32
     signal(SIGSEGV, crash_handler);
@@ -44,10 +46,14 @@ int main(int argc, char *argv[]) {
         qRegisterMetaType<ReturnCallback>("ReturnCallback");
         qRegisterMetaType<WindowEvent>("WindowEvent");
 
+        const std::string METRICS_FILE_ARG = "--bridge-metrics=";
+        QString metricsFile;
         for (int i = 1; i < argc; i++) {
             if (argv[i] == std::string("--version")) {
                 std::cout << VERSION_STRING << std::endl;
                 return 0;
+            } else if (std::string(argv[i]).compare(0, METRICS_FILE_ARG.size(), METRICS_FILE_ARG) == 0) {
+                metricsFile = QString::fromStdString(std::string(argv[i]).substr(METRICS_FILE_ARG.size()));
             }
         }
 
@@ -61,6 +67,8 @@ int main(int argc, char *argv[]) {
         /*allTests();
         return 0;*/
 
+        RsaKeysPool rsaKeysPool(RSA_KEYS_POOL_SIZE);
+
         const std::string versionString = VERSION_STRING;
 
         std::string typeString;
@@ -86,6 +94,9 @@ int main(int argc, char *argv[]) {
             webSocketClient.start();
 
             JavascriptWrapper jsWrapper(nsLookup);
+            if (!metricsFile.isEmpty()) {
+                jsWrapper.setMetricsFile(metricsFile);
+            }
 
             MainWindow mainWindow(webSocketClient, jsWrapper, QString::fromStdString(versionString));
             mainWindow.showExpanded();
@@ -520,6 +520,7 @@ void MainWindow::softReloadApp() {
 
 void MainWindow::loadUrl(const QString &page) {
     ui->webView->page()->profile()->setRequestInterceptor(nullptr);
+    jsWrapper.setStructuredResults(false);
     ui->webView->load(page);
     LOG << "Reload ok";
 }
@@ -544,6 +545,7 @@ private:
 void MainWindow::loadUrl(const QWebEngineHttpRequest &url) {
     RequestInterceptor *interceptor = new RequestInterceptor(ui->webView, url.header("host"));
     ui->webView->page()->profile()->setRequestInterceptor(interceptor);
+    jsWrapper.setStructuredResults(false);
     ui->webView->load(url);
     LOG << "Reload ok";
 }
@@ -5,41 +5,148 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <mutex>
 
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
 #include <openssl/x509.h>
+#include <openssl/crypto.h>
 
 #include <QString>
 #include <QByteArray>
 
 #include "check.h"
 #include "utils.h"
+#include "Log.h"
+#include "duration.h"
 
 static bool isInitialized = false;
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+// До версии 1.1 openssl сам не синхронизирует потоки
+static std::unique_ptr<std::mutex[]> opensslMutexes;
+
+static void opensslLockingCallback(int mode, int n, const char */*file*/, int /*line*/) {
+    if (mode & CRYPTO_LOCK) {
+        opensslMutexes[n].lock();
+    } else {
+        opensslMutexes[n].unlock();
+    }
+}
+#endif
+
 void InitOpenSSL() {
     CHECK(!isInitialized, "Already initialized");
     /*SSL_load_error_strings();
     SSL_library_init();*/
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    opensslMutexes.reset(new std::mutex[CRYPTO_num_locks()]);
+    CRYPTO_set_locking_callback(opensslLockingCallback);
+#endif
     OpenSSL_add_all_algorithms();
     isInitialized = true;
 }
 
-std::pair<PrivateKey, PublikKey> createRsaKey(const std::string &password) {
-    CHECK(isInitialized, "Not initialized");
-
-    CHECK(password.find('\0') == password.npos, "Incorrect password");
+using RsaPtr = std::unique_ptr<RSA, void(*)(RSA*)>;
 
+static RsaPtr generateRsaKey() {
     const int kBits = 2048;
 
     std::unique_ptr<BIGNUM, std::function<void(BIGNUM*)>> bne(BN_new(), BN_free);
     const bool res1 = BN_set_word(bne.get(), 17);
     CHECK(res1, "Incorrect BN_set_word");
 
-    std::unique_ptr<RSA, std::function<void(RSA*)>> rsa(RSA_new(), RSA_free);
+    RsaPtr rsa(RSA_new(), RSA_free);
     const bool res2 = RSA_generate_key_ex(rsa.get(), kBits, bne.get(), nullptr); // TODO random generator ?
     CHECK(res2, "Incorrect RSA_generate_key_ex");
+    return rsa;
+}
+
+const static seconds POOL_RETRY_MIN = 1s;
+const static seconds POOL_RETRY_MAX = 60s;
+
+// Под мьютексом, чтобы пул не уничтожился, пока createRsaKey берет из него ключ
+static std::mutex rsaKeysPoolMut;
+static RsaKeysPool *rsaKeysPool = nullptr;
+
+RsaKeysPool::RsaKeysPool(size_t countKeys)
+    : countKeys(countKeys)
+{
+    CHECK(isInitialized, "Not initialized");
+    std::lock_guard<std::mutex> lock(rsaKeysPoolMut);
+    CHECK(rsaKeysPool == nullptr, "Rsa keys pool already started");
+    thread = std::thread(&RsaKeysPool::work, this);
+    rsaKeysPool = this;
+}
+
+RsaKeysPool::~RsaKeysPool() {
+    {
+        std::lock_guard<std::mutex> lock(rsaKeysPoolMut);
+        rsaKeysPool = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        isStopped = true;
+    }
+    cond.notify_all();
+    thread.join();
+}
+
+RsaPtr RsaKeysPool::get() {
+    RsaPtr result(nullptr, RSA_free);
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        if (!keys.empty()) {
+            result = std::move(keys.front());
+            keys.pop_front();
+        }
+    }
+    cond.notify_all();
+    return result;
+}
+
+void RsaKeysPool::work() {
+    seconds retryTimeout = POOL_RETRY_MIN;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            cond.wait(lock, [this]{ return isStopped || keys.size() < countKeys; });
+            if (isStopped) {
+                return;
+            }
+        }
+        try {
+            RsaPtr rsa = generateRsaKey();
+            std::lock_guard<std::mutex> lock(mut);
+            keys.emplace_back(std::move(rsa));
+            retryTimeout = POOL_RETRY_MIN;
+        } catch (const Exception &e) {
+            // Пока пул пуст, createRsaKey генерирует ключи сам, так что ошибка не фатальна
+            LOG << "Error while generate rsa key for pool: " << e << ". Retry after " << retryTimeout.count() << " seconds";
+            std::unique_lock<std::mutex> lock(mut);
+            if (cond.wait_for(lock, retryTimeout, [this]{ return isStopped; })) {
+                return;
+            }
+            retryTimeout = std::min(retryTimeout * 2, POOL_RETRY_MAX);
+        }
+    }
+}
+
+std::pair<PrivateKey, PublikKey> createRsaKey(const std::string &password) {
+    CHECK(isInitialized, "Not initialized");
+
+    CHECK(password.find('\0') == password.npos, "Incorrect password");
+
+    RsaPtr rsa(nullptr, RSA_free);
+    {
+        std::lock_guard<std::mutex> lock(rsaKeysPoolMut);
+        if (rsaKeysPool != nullptr) {
+            rsa = rsaKeysPool->get();
+        }
+    }
+    if (rsa == nullptr) {
+        rsa = generateRsaKey();
+    }
 
     std::unique_ptr<BIO, std::function<void(BIO*)>> bio(BIO_new(BIO_s_mem()), BIO_free);
     if (!password.empty()) {
@@ -85,11 +192,9 @@ std::string encrypt(const std::string &pubkey, const std::string &message) {
     return toHex(std::string(encrypt.begin(), encrypt.end()));
 }
 
-std::string decrypt(const std::string &privkey, const std::string &password, const std::string &message) {
+RsaKey readRsaKey(const std::string &privkey, const std::string &password) {
     CHECK(isInitialized, "Not initialized");
 
-    const std::string normMessage = fromHex(message);
-
     std::unique_ptr<BIO, std::function<void(BIO*)>> bio(BIO_new_mem_buf((void*)privkey.data(), (int)privkey.size()), BIO_free);
     CHECK(bio != nullptr, "Incorrect BIO_new_mem_buf");
 
@@ -100,13 +205,25 @@ std::string decrypt(const std::string &privkey, const std::string &password, con
     std::unique_ptr<EVP_PKEY, std::function<void(EVP_PKEY*)>> evp(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, (void*)pswd), EVP_PKEY_free);
     CHECK(evp != nullptr, "Incorrect password");
 
-    std::unique_ptr<RSA, std::function<void(RSA*)>> rsa(EVP_PKEY_get1_RSA(evp.get()), RSA_free);
+    RsaKey rsa(EVP_PKEY_get1_RSA(evp.get()), RSA_free);
     CHECK(rsa != nullptr, "Incorrect EVP_PKEY_get1_RSA");
+    return rsa;
+}
 
-    std::vector<unsigned char> encrypt(RSA_size(rsa.get()));
-    const int encrypt_len = RSA_private_decrypt(normMessage.size(), (unsigned char*)normMessage.data(), encrypt.data(), rsa.get(), RSA_PKCS1_OAEP_PADDING);
+std::string decrypt(const RsaKey &privkey, const std::string &message) {
+    CHECK(isInitialized, "Not initialized");
+    CHECK(privkey != nullptr, "Empty rsa key");
+
+    const std::string normMessage = fromHex(message);
+
+    std::vector<unsigned char> encrypt(RSA_size(privkey.get()));
+    const int encrypt_len = RSA_private_decrypt(normMessage.size(), (unsigned char*)normMessage.data(), encrypt.data(), privkey.get(), RSA_PKCS1_OAEP_PADDING);
     CHECK(encrypt_len != -1, "Incorrect RSA_public_encrypt");
     encrypt.resize(encrypt_len);
 
     return std::string(encrypt.begin(), encrypt.end());
 }
+
+std::string decrypt(const std::string &privkey, const std::string &password, const std::string &message) {
+    return decrypt(readRsaKey(privkey, password), message);
+}
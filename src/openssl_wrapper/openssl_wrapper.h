@@ -2,6 +2,13 @@
 #define OPENSSL_WRAPPER_H
 
 #include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+struct rsa_st;
 
 void InitOpenSSL();
 
@@ -9,8 +16,52 @@ using PrivateKey = std::string;
 using PublikKey = std::string;
 std::pair<PrivateKey, PublikKey> createRsaKey(const std::string &password);
 
+/*
+   Пул заранее сгенерированных rsa ключей. Пока пул существует, createRsaKey берет ключ из него,
+   а фоновый поток догенерирует ключи до countKeys. Если пул пуст, ключ генерируется как раньше.
+   Ключи пула хранятся в памяти нешифрованными и выдаются только один раз.
+   */
+class RsaKeysPool {
+public:
+
+    explicit RsaKeysPool(size_t countKeys);
+
+    ~RsaKeysPool();
+
+    RsaKeysPool(const RsaKeysPool &) = delete;
+    RsaKeysPool& operator=(const RsaKeysPool &) = delete;
+
+    std::unique_ptr<rsa_st, void(*)(rsa_st*)> get();
+
+private:
+
+    void work();
+
+private:
+
+    const size_t countKeys;
+
+    std::deque<std::unique_ptr<rsa_st, void(*)(rsa_st*)>> keys;
+
+    bool isStopped = false;
+
+    std::mutex mut;
+
+    std::condition_variable cond;
+
+    std::thread thread;
+
+};
+
 std::string encrypt(const std::string &pubkey, const std::string &message);
 
 std::string decrypt(const std::string &privkey, const std::string &password, const std::string &message);
 
+// Разобранный и расшифрованный паролем приватный ключ. Можно использовать из нескольких потоков
+using RsaKey = std::shared_ptr<rsa_st>;
+
+RsaKey readRsaKey(const std::string &privkey, const std::string &password);
+
+std::string decrypt(const RsaKey &privkey, const std::string &message);
+
 #endif // OPENSSL_WRAPPER_H
@@ -1,6 +1,10 @@
 #include "tests2.h"
 
 #include <iostream>
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 
 #include "check.h"
 
@@ -11,15 +15,27 @@
 #include "EthWallet.h"
 #include "BtcWallet.h"
 #include "utils.h"
+#include "WalletsCache.h"
 
 #include "btctx/Base58.h"
 
 #include "openssl_wrapper/openssl_wrapper.h"
 
 #include "ethtx/utils2.h"
+#include "ethtx/cert.h"
+#include "ethtx/keccak.h"
+#include "ethtx/rlp.h"
+#include "ethtx/abi.h"
+#include "ethtx/secp256k1ctx.h"
+#include "ethtx/const.h"
 
 #include "btctx/wif.h"
 
+#include "ethtx/scrypt/libscrypt.h"
+#include "ethtx/scrypt/sha256.h"
+
+#include <cerrno>
+
 static void testSsl(const std::string &password, const std::string &message) {
     const auto pair = createRsaKey(password);
     //std::cout << pair.first << "\n" << pair.second << std::endl;
@@ -32,6 +48,36 @@ static void testSsl(const std::string &password, const std::string &message) {
     std::cout << "Ok" << std::endl;
 }
 
+static void testSslBatch(const std::string &password) {
+    const auto pair = createRsaKey(password);
+    std::vector<std::string> messages;
+    std::vector<std::string> encryptedMessages;
+    for (size_t i = 0; i < 20; i++) {
+        messages.emplace_back("Message " + std::to_string(i));
+        encryptedMessages.emplace_back(encrypt(pair.second, messages.back()));
+    }
+
+    const RsaKey rsaKey = readRsaKey(pair.first, password);
+    const std::vector<std::string> decryptMessages = Wallet::decryptMessages(rsaKey, encryptedMessages);
+    CHECK(decryptMessages == messages, "Incorrect decrypt batch");
+
+    RsaKeysCache cache;
+    cache.add("folder", "Address", password, rsaKey, seconds(10));
+    CHECK(cache.find("folder", "address", password) == rsaKey, "Rsa key not cached");
+    CHECK(cache.find("folder", "address", password + "1") == nullptr, "Incorrect password accepted");
+    cache.clear();
+    CHECK(cache.find("folder", "address", password) == nullptr, "Rsa key not removed");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testSslPool(const std::string &password, const std::string &message) {
+    RsaKeysPool pool(2);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    for (size_t i = 0; i < 3; i++) {
+        testSsl(password, message);
+    }
+}
+
 static void testEncryptBtc() {
     const std::string result = encryptWif("5KN7MzqK5wt2TP1fQCYyHBtDrXdJuXbUzm4A9rKAteGu3Qi5CVR", QString("TestingOneTwoThree").normalized(QString::NormalizationForm_C).toStdString());
     CHECK(result == "6PRVWUbkzzsbcVac2qwfssoUJAN1Xhrg6bNk8J7Nzm5H7kxEbn2Nh2ZoGg", "Incorrect result: " + result);
@@ -76,6 +122,261 @@ static void testCreateBtc(const QString &passwd) {
     std::cout << "Ok" << std::endl;
 }
 
+static void testKdfProfiles() {
+    CHECK(getEthKdfProfile(KDF_PROFILE_STANDARD) == (ScryptParams{SCRYPT_DEFAULT_N, SCRYPT_DEFAULT_r, SCRYPT_DEFAULT_p}), "Incorrect standard eth profile");
+    CHECK(getBtcKdfProfile(KDF_PROFILE_STANDARD) == BIP38_SCRYPT_PARAMS, "Incorrect standard btc profile");
+    bool isThrow = false;
+    try {
+        getEthKdfProfile("unknown");
+    } catch (const Exception &) {
+        isThrow = true;
+    }
+    CHECK(isThrow, "Unknown profile accepted");
+
+    const std::string ethAddress = EthWallet::genPrivateKey("./", "Password 1", KDF_PROFILE_INTERACTIVE);
+    EthWallet ethWallet("./", ethAddress, "Password 1");
+
+    const std::string btcAddress = BtcWallet::genPrivateKey("./", "Password 1", KDF_PROFILE_INTERACTIVE).first;
+    BtcWallet btcWallet("./", btcAddress, "Password 1");
+    CHECK(btcAddress == btcWallet.getAddress(), "Incorrect address");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testWalletsCache(const std::string &passwd) {
+    std::string tmp;
+    std::string address;
+    Wallet::createWallet("./", passwd, tmp, address);
+    const std::string privateKey = Wallet("./", address, passwd).getPrivateKeyBinary();
+
+    WalletsCache cache;
+    cache.unlock("./", address, passwd, privateKey, 10s);
+    CHECK(cache.find("./", address, passwd + "1") == nullptr, "Incorrect password accepted");
+    const std::shared_ptr<const LockedBuffer> secret = cache.find("./", address, passwd);
+    CHECK(secret != nullptr, "Wallet not unlocked");
+    CHECK(std::string(secret->data(), secret->size()) == privateKey, "Incorrect secret");
+    CHECK(Wallet(secret->data(), secret->size()).getPrivateKeyBinary() == privateKey, "Incorrect private key");
+    cache.lock("./", address);
+    CHECK(cache.find("./", address, passwd) == nullptr, "Wallet not locked");
+    CHECK(std::string(secret->data(), secret->size()) == privateKey, "Secret released while in use");
+
+    cache.unlock("./", address, passwd, privateKey, 0s);
+    CHECK(cache.find("./", address, passwd) == nullptr, "Wallet not expired");
+    std::cout << "Ok" << std::endl;
+}
+
+static int cancelScryptOnHalf(void */*arg*/, uint64_t done, uint64_t total) {
+    return done >= total / 2 ? 1 : 0;
+}
+
+static void testScryptCancel() {
+    std::array<uint8_t, 64> derivedKey;
+    libscrypt_set_thread_progress(&cancelScryptOnHalf, nullptr);
+    const int result = libscrypt_scrypt((const uint8_t*)"password", 8, (const uint8_t*)"NaCl", 4, 1024, 8, 16, derivedKey.data(), derivedKey.size());
+    const int error = errno;
+    libscrypt_set_thread_progress(nullptr, nullptr);
+    CHECK(result == -1 && error == ECANCELED, "scrypt not cancelled");
+
+    const int result2 = libscrypt_scrypt((const uint8_t*)"password", 8, (const uint8_t*)"NaCl", 4, 1024, 8, 16, derivedKey.data(), derivedKey.size());
+    CHECK(result2 == 0, "scrypt error");
+    CHECK(toHex(std::string(derivedKey.begin(), derivedKey.end())).substr(0, 16) == "fdbabe1c9d347200", "Incorrect scrypt result");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testScryptKernels() {
+    struct Vector {
+        std::string password;
+        std::string salt;
+        uint64_t N;
+        uint32_t r;
+        uint32_t p;
+        std::string result;
+    };
+    // RFC 7914, раздел 12
+    const std::vector<Vector> vectors = {
+        {"", "", 16, 1, 1, "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906"},
+        {"password", "NaCl", 1024, 8, 16, "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640"},
+        {"pleaseletmein", "SodiumChloride", 16384, 8, 1, "7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887"},
+    };
+
+    for (const libscrypt_kernel kernel: {LIBSCRYPT_KERNEL_NOSSE, LIBSCRYPT_KERNEL_SSE2, LIBSCRYPT_KERNEL_AVX2}) {
+        if (libscrypt_set_kernel(kernel) != 0) {
+            std::cout << "Scrypt kernel " << kernel << " not supported" << std::endl;
+            continue;
+        }
+        for (const Vector &v: vectors) {
+            std::array<uint8_t, 64> derivedKey;
+            const int result = libscrypt_scrypt((const uint8_t*)v.password.data(), v.password.size(), (const uint8_t*)v.salt.data(), v.salt.size(), v.N, v.r, v.p, derivedKey.data(), derivedKey.size());
+            CHECK(result == 0, "scrypt error");
+            const std::string resultHex = toHex(std::string(derivedKey.begin(), derivedKey.end()));
+            CHECK(resultHex == v.result, "Incorrect scrypt result kernel " + std::to_string(kernel) + ": " + resultHex);
+        }
+    }
+
+    // Нечетное p на параллельном пути: деление на части и пары линий AVX2 сверяются с однопоточным NOSSE
+    const auto scrypt7 = []() {
+        std::array<uint8_t, 64> derivedKey;
+        const int result = libscrypt_scrypt((const uint8_t*)"password", 8, (const uint8_t*)"NaCl", 4, 1024, 8, 7, derivedKey.data(), derivedKey.size());
+        CHECK(result == 0, "scrypt error");
+        return derivedKey;
+    };
+    libscrypt_set_kernel(LIBSCRYPT_KERNEL_NOSSE);
+    libscrypt_set_threads(1);
+    const std::array<uint8_t, 64> expected = scrypt7();
+    for (const libscrypt_kernel kernel: {LIBSCRYPT_KERNEL_NOSSE, LIBSCRYPT_KERNEL_SSE2, LIBSCRYPT_KERNEL_AVX2}) {
+        if (libscrypt_set_kernel(kernel) != 0) {
+            continue;
+        }
+        for (const uint32_t threads: {1, 2, 3, 7}) {
+            libscrypt_set_threads(threads);
+            CHECK(scrypt7() == expected, "Incorrect scrypt p=7 kernel " + std::to_string(kernel) + " threads " + std::to_string(threads));
+        }
+    }
+    libscrypt_set_threads(0);
+    libscrypt_set_kernel(LIBSCRYPT_KERNEL_AUTO);
+    std::cout << "Ok" << std::endl;
+}
+
+static void testScryptBatch() {
+    const std::string password = "password";
+    const std::vector<std::pair<uint64_t, uint32_t>> params = {{1024, 1}, {2048, 1}, {1024, 1}, {1024, 3}, {16, 2}};
+    std::vector<std::string> salts;
+    std::vector<std::array<uint8_t, 32>> derivedKeys(params.size());
+    std::vector<libscrypt_batch_item> items;
+    for (size_t i = 0; i < params.size(); i++) {
+        salts.emplace_back("salt " + std::to_string(i));
+    }
+    for (size_t i = 0; i < params.size(); i++) {
+        items.push_back(libscrypt_batch_item{(const uint8_t*)password.data(), password.size(), (const uint8_t*)salts[i].data(), salts[i].size(), params[i].first, 8, params[i].second, derivedKeys[i].data(), derivedKeys[i].size(), 0});
+    }
+    const int result = libscrypt_scrypt_batch(items.data(), items.size());
+    CHECK(result == 0, "scrypt batch error");
+
+    for (size_t i = 0; i < params.size(); i++) {
+        std::array<uint8_t, 32> derivedKey;
+        const int result2 = libscrypt_scrypt((const uint8_t*)password.data(), password.size(), (const uint8_t*)salts[i].data(), salts[i].size(), params[i].first, 8, params[i].second, derivedKey.data(), derivedKey.size());
+        CHECK(result2 == 0, "scrypt error");
+        CHECK(items[i].result == 0 && derivedKey == derivedKeys[i], "Incorrect scrypt batch result " + std::to_string(i));
+    }
+    std::cout << "Ok" << std::endl;
+}
+
+static void testSha256() {
+    const auto sha256 = [](const std::string &data, bool isDouble) {
+        std::array<uint8_t, SHA256_DIGEST_SIZE> hash;
+        if (isDouble) {
+            libscrypt_SHA256d(data.data(), data.size(), hash.data());
+        } else {
+            libscrypt_SHA256(data.data(), data.size(), hash.data());
+        }
+        return toHex(std::string(hash.begin(), hash.end()));
+    };
+    const auto pbkdf2 = [](const std::string &password, const std::string &salt, uint64_t c, size_t dkLen) {
+        std::string result(dkLen, 0);
+        libscrypt_PBKDF2_SHA256((const uint8_t*)password.data(), password.size(), (const uint8_t*)salt.data(), salt.size(), c, (uint8_t*)&result[0], dkLen);
+        return toHex(result);
+    };
+
+    CHECK(sha256("abc", false) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "Incorrect sha256");
+    CHECK(sha256("", true) == "5df6e0e2761359d30a8275058e299fcc0381534545f55cf43e41983f5d4c9456", "Incorrect double sha256");
+    CHECK(pbkdf2("password", "salt", 1, 32) == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b", "Incorrect pbkdf2 1");
+    CHECK(pbkdf2("password", "salt", 4096, 32) == "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a", "Incorrect pbkdf2 2");
+    CHECK(pbkdf2("passwd", "salt", 1, 64) == "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783", "Incorrect pbkdf2 3");
+    CHECK(pbkdf2("passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 40) == "348c89dbcbd32b2f32d814b8116e84cf2b17347ebc1800181c4e2a1fb8dd53e1c635518c7dac47e9", "Incorrect pbkdf2 4");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testKeccak() {
+    CHECK(toHex(std::string((const char*)Keccak256("").data(), KECCAK256_HASH_LENGTH)) == "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470", "Incorrect keccak256");
+    CHECK(toHex(std::string((const char*)Keccak256("abc").data(), KECCAK256_HASH_LENGTH)) == "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45", "Incorrect keccak256");
+
+    std::vector<std::string> messages;
+    for (size_t i = 0; i < 11; i++) {
+        messages.emplace_back(i * 37, (char)i);
+    }
+    const std::vector<Keccak256Hash> hashes = Keccak256Batch(messages);
+    for (size_t i = 0; i < messages.size(); i++) {
+        CHECK(hashes[i] == Keccak256(messages[i]), "Incorrect keccak256 batch " + std::to_string(i));
+    }
+
+    const std::vector<std::string> addresses = {
+        "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed",
+        "0xfB6916095ca1df60bB79Ce92cE3Ea74c37c5d359",
+        "0xdbF03B407c01E7cD3CBea99509d93f8DDDC8C6FB",
+        "0xD1220A0cf47c7B9Be7A2E6BA89F429762e7b9aDb"
+    };
+    std::vector<std::string> binaryAddresses;
+    for (const std::string &address: addresses) {
+        binaryAddresses.emplace_back(HexStringToDump(address.substr(2)));
+    }
+    const std::vector<std::string> encoded = MixedCaseEncoding(binaryAddresses);
+    for (size_t i = 0; i < addresses.size(); i++) {
+        CHECK("0x" + encoded[i] == addresses[i], "Incorrect mixed case encoding " + encoded[i]);
+        CHECK("0x" + MixedCaseEncoding(binaryAddresses[i]) == addresses[i], "Incorrect mixed case encoding " + addresses[i]);
+    }
+
+    const std::vector<bool> checked = CheckMixedCaseAddresses({addresses[0], "0x5aaeb6053f3e94c9b9a09f33669435e7ef1beaed", "0x5AAeb6053F3E94C9b9A09f33669435E7Ef1BeAed", "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAe", "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAeg"});
+    CHECK(checked == std::vector<bool>({true, true, false, false, false}), "Incorrect checksum validation");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testHex() {
+    std::string dump;
+    for (size_t i = 0; i < 300; i++) {
+        dump += (char)(i * 37);
+    }
+    for (size_t size = 0; size <= dump.size(); size += 7) {
+        const std::string part = dump.substr(0, size);
+        const std::string hex = DumpToHexString(part);
+        CHECK(hex == toHex(part), "Incorrect hex " + hex);
+        CHECK(HexStringToDump(hex) == part, "Incorrect dump " + hex);
+        std::string upper = hex;
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        CHECK(fromHex(upper) == part, "Incorrect dump " + upper);
+    }
+    CHECK(DumpToHexString(HexStringToDump("abc")) == "0abc", "Incorrect odd hex");
+    bool isThrow = false;
+    try {
+        HexStringToDump("0x12");
+    } catch (const Exception &) {
+        isThrow = true;
+    }
+    CHECK(isThrow, "Incorrect hex accepted");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testBase58() {
+    const std::vector<std::pair<std::string, std::string>> vectors = {
+        {"", ""},
+        {"61", "2g"},
+        {"626262", "a3gV"},
+        {"00000000000000000000", "1111111111"},
+        {"00eb15231dfceb60925886b67d065299925915aeb172c06647", "1NS17iag9jJgTHD1VXjvLCEnZuQ3rJDE9L"},
+        {"ecac89cad93923c02321", "EJDM8drfXA6uyA"},
+        {"572e4794", "3EFU7m"},
+    };
+    for (const auto &pair: vectors) {
+        const std::string dump = HexStringToDump(pair.first);
+        const std::string encoded = EncodeBase58BTC((const unsigned char*)dump.data(), (const unsigned char*)dump.data() + dump.size());
+        CHECK(encoded == pair.second, "Incorrect base58 " + encoded);
+        std::vector<unsigned char> decoded;
+        CHECK(DecodeBase58(encoded.c_str(), decoded), "Incorrect base58 " + encoded);
+        CHECK(std::string(decoded.begin(), decoded.end()) == dump, "Incorrect base58 decode " + encoded);
+    }
+    std::vector<unsigned char> decoded;
+    CHECK(!DecodeBase58("3EFU0m", decoded), "Incorrect base58 accepted");
+
+    const std::vector<bool> result = validateAddresses({
+        "1BvBMSEYstWetqTFn5Au4m4GFg7xJaNVN2",
+        "3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy",
+        "1BvBMSEYstWetqTFn5Au4m4GFg7xJaNVN3",
+        "1BvBMSEYstWetqTFn5Au4m4GFg7xJaNVN",
+        "1BvBMSEYstWetqTFn5Au4m4GFg7xJaNV0",
+        "1111111111111111111114oLvT2",
+    });
+    CHECK(result == std::vector<bool>({true, true, false, false, false, true}), "Incorrect validateAddresses");
+    std::cout << "Ok" << std::endl;
+}
+
 static void testEthWallet() {
     writeToFile("./123", "{\"address\": \"05cf594f12bba9430e34060498860abc69554cb1\",\"crypto\": {\"cipher\": \"aes-128-ctr\",\"ciphertext\": \"694283a4a2f3da99186e2321c24cf1b427d81a273e7bc5c5a54ab624c8930fb8\",\"cipherparams\": {\"iv\": \"5913da2f0f6cd00b9b62ff2bc0a8b9d3\"},\"kdf\": \"scrypt\",\"kdfparams\": {\"dklen\": 32,\"n\": 262144,\"p\": 1,\"r\": 8,\"salt\": \"ca45d433267bd6a50ace149d6b317b9d8f8a39f43621bad2a3108981bf533ee7\"},\"mac\": \"0a8d581e8c60553970301603ea35b0fc56cbccd5913b12f62c690acb98d111c8\"},\"id\": \"6406896a-2ec9-4dd7-b98e-5fbfc0984e6f\",\"version\": 3}", false);
     const std::string password = "1";
@@ -91,6 +392,189 @@ static void testEthWallet() {
     CHECK(result == "0xf899018506c088e200828208948d78b1ab426dc9daa7427b7a60e64633f62e645f85746a528800b001010101010101010101010101010101010101010101010101010101010101010101010101010101010101010101010126a047dd9f6ebce749230df9ac9d57db85f948db0775882cb63565501fe95ddfcb58a07c7020426395bc781fc06e4fbb5cffc5c4d8b77d37596b1c83fa0c21ce37cfb3", "Incorrect result: " + result);
 }
 
+static void testSignTransactionsEth() {
+    EthWallet wallet(std::string(32, '\x11'));
+    const std::string to = "0x8D78B1Ab426dc9daa7427b7A60E64633f62E645F";
+    std::vector<EthTransaction> transactions;
+    for (const char *nonce: {"0x3", "0x01", "0x2", "0x0"}) {
+        EthTransaction tx;
+        tx.nonce = nonce;
+        tx.gasPrice = "0x6C088E200";
+        tx.gasLimit = "0x8208";
+        tx.to = to;
+        tx.value = "0x746A528800";
+        tx.data = "0x";
+        transactions.push_back(tx);
+    }
+    const std::vector<std::string> result = wallet.SignTransactions(transactions);
+    CHECK(result.size() == 4, "Incorrect batch size");
+    for (size_t i = 0; i < result.size(); i++) {
+        const std::string single = wallet.SignTransaction("0x" + std::to_string(i), "0x6C088E200", "0x8208", to, "0x746A528800", "0x");
+        CHECK(result[i] == single, "Incorrect batch transaction " + std::to_string(i));
+    }
+
+    transactions.push_back(transactions[0]);
+    bool isThrow = false;
+    try {
+        wallet.SignTransactions(transactions);
+    } catch (const Exception &) {
+        isThrow = true;
+    }
+    CHECK(isThrow, "Duplicate nonce accepted");
+
+    transactions.back().nonce = "0x5";
+    isThrow = false;
+    try {
+        wallet.SignTransactions(transactions);
+    } catch (const Exception &) {
+        isThrow = true;
+    }
+    CHECK(isThrow, "Nonce gap accepted");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testSignTypedTransactionEth() {
+    EthWallet wallet(std::string(32, '\x46'));
+    EthTransaction tx;
+    tx.nonce = "0x9";
+    tx.gasPrice = "0x4a817c800";
+    tx.gasLimit = "0x5208";
+    tx.to = "0x3535353535353535353535353535353535353535";
+    tx.value = "0xde0b6b3a7640000";
+    // Пример из EIP-155
+    const std::string legacy = wallet.SignTransaction(tx);
+    CHECK(legacy == "0xf86c098504a817c800825208943535353535353535353535353535353535353535880de0b6b3a76400008025a028ef61340bd939bc2195fe537567866003e1a15d3c71ff63e1590620aa636276a067cbe9d8997f761aecb703304b3800ccf555c9f3dc64214b297fb1966a3b6d83", "Incorrect legacy transaction " + legacy);
+    CHECK(legacy == wallet.SignTransaction(tx.nonce, tx.gasPrice, tx.gasLimit, tx.to, tx.value, tx.data), "Incorrect legacy transaction");
+
+    tx.type = EthTransactionType::EIP1559;
+    tx.chainId = 5;
+    tx.maxPriorityFeePerGas = "0x3b9aca00";
+    tx.maxFeePerGas = "0x4a817c800";
+    tx.value = "0x1";
+    tx.data = "0xabcd";
+    tx.accessList.push_back(EthAccessListEntry{"0x1111111111111111111111111111111111111111", {"0x" + std::string(64, '0'), "0x" + std::string(63, '0') + "1"}});
+    tx.accessList.push_back(EthAccessListEntry{"0x2222222222222222222222222222222222222222", {}});
+    const std::string typed = wallet.SignTransaction(tx);
+    CHECK(typed == "0x02f8e00509843b9aca008504a817c8008252089435353535353535353535353535353535353535350182abcdf872f859941111111111111111111111111111111111111111f842a00000000000000000000000000000000000000000000000000000000000000000a00000000000000000000000000000000000000000000000000000000000000001d6942222222222222222222222222222222222222222c001a0da26411d81fb42b5e805d4419487ba76ee88f599177d5745656a51d0a4502c1da03e69fe94bada2b2a016ae501398f826f3c5a22c7f0c5cbf8819a434223507445", "Incorrect eip1559 transaction " + typed);
+
+    tx.type = EthTransactionType::LEGACY;
+    bool isThrow = false;
+    try {
+        wallet.SignTransaction(tx);
+    } catch (const Exception &) {
+        isThrow = true;
+    }
+    CHECK(isThrow, "Legacy transaction with accessList accepted");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testErc20Payouts() {
+    const std::string to = "0x8D78B1Ab426dc9daa7427b7A60E64633f62E645F";
+    const std::string transfer = "0xa9059cbb0000000000000000000000008d78b1ab426dc9daa7427b7a60e64633f62e645f000000000000000000000000000000000000000000000000000000746a528800";
+    CHECK(Erc20TransferData(to, "0x746A528800") == transfer, "Incorrect erc20 data " + Erc20TransferData(to, "0x746A528800"));
+    CHECK(Erc20TransferData(to, "500000000000") == transfer, "Incorrect erc20 decimal amount");
+    CHECK(EthWallet::makeErc20Data("0x746A528800", to) == transfer, "Incorrect erc20 data");
+
+    uint8_t slot[ABI_SLOT_SIZE];
+    AbiEncodeUint256("115792089237316195423570985008687907853269984665640564039457584007913129639935", slot);
+    CHECK(std::all_of(slot, slot + ABI_SLOT_SIZE, [](uint8_t b) { return b == 0xff; }), "Incorrect uint256 max");
+    for (const char *incorrect: {"115792089237316195423570985008687907853269984665640564039457584007913129639936", "0x1" "0000000000000000000000000000000000000000000000000000000000000000", "12a", "0x"}) {
+        bool isThrow = false;
+        try {
+            AbiEncodeUint256(incorrect, slot);
+        } catch (const Exception &) {
+            isThrow = true;
+        }
+        CHECK(isThrow, std::string("Incorrect uint256 accepted ") + incorrect);
+    }
+
+    EthTransaction base;
+    base.nonce = "0xff";
+    base.gasPrice = "0x6C088E200";
+    base.gasLimit = "0xea60";
+    base.to = "0x2222222222222222222222222222222222222222";
+    const std::vector<EthTransaction> transactions = EthWallet::makeErc20Payouts(base, {Erc20Payout{to, "0x746A528800"}, Erc20Payout{to, "1"}});
+    CHECK(transactions.size() == 2, "Incorrect payouts size");
+    CHECK(transactions[0].nonce == "0xff" && transactions[1].nonce == "0x100", "Incorrect payouts nonce");
+    CHECK(transactions[0].data == transfer && transactions[1].to == base.to && transactions[1].value == "0x0", "Incorrect payout transaction");
+    bool isThrow = false;
+    try {
+        EthWallet::makeErc20Payouts(base, {Erc20Payout{to, "1"}, Erc20Payout{"0x8d78B1Ab426dc9daa7427b7A60E64633f62E645F", "1"}});
+    } catch (const Exception &) {
+        isThrow = true;
+    }
+    CHECK(isThrow, "Incorrect payout checksum accepted");
+    std::cout << "Ok" << std::endl;
+}
+
+static void testSecp256k1Contexts() {
+    const secp256k1_context* mainCtx = getCtx();
+    CHECK(getCtx() == mainCtx, "Context changed in thread");
+    const secp256k1_context* threadCtx = nullptr;
+    std::thread([&threadCtx]() {
+        threadCtx = getCtx();
+    }).join();
+    CHECK(threadCtx != nullptr && threadCtx != mainCtx, "Context shared between threads");
+
+    // Обновление ослепления не меняет подписи
+    EthWallet wallet(std::string(32, '\x46'));
+    const std::string first = wallet.SignTransaction("0x9", "0x4a817c800", "0x5208", "0x3535353535353535353535353535353535353535", "0xde0b6b3a7640000", "");
+    for (size_t i = 0; i < 2000; i++) {
+        CHECK(wallet.SignTransaction("0x9", "0x4a817c800", "0x5208", "0x3535353535353535353535353535353535353535", "0xde0b6b3a7640000", "") == first, "Signature changed after randomization");
+    }
+    std::cout << "Ok" << std::endl;
+}
+
+static void testRlp() {
+    CHECK(DumpToHexString(RLP({"cat", "dog"})) == "c88363617483646f67", "Incorrect rlp");
+    CHECK(DumpToHexString(RLP({})) == "c0", "Incorrect rlp");
+    CHECK(DumpToHexString(RLP({std::string(1, '\0'), std::string(1, '\x7f'), std::string(1, '\x80')})) == "c4807f8180", "Incorrect rlp");
+    const std::string longField(1024, 'a');
+    const std::string longRlp = RLP({longField});
+    CHECK(DumpToHexString(longRlp.substr(0, 7)) == "f90403b9040061", "Incorrect rlp " + DumpToHexString(longRlp.substr(0, 7)));
+
+    RlpReader longReader((const uint8_t*)longRlp.data(), longRlp.size());
+    RlpReader longList = longReader.nextList();
+    const RlpItem longItem = longList.nextString();
+    CHECK(std::string((const char*)longItem.data, longItem.size) == longField, "Incorrect rlp decode");
+    CHECK(longList.isEnd() && longReader.isEnd(), "Incorrect rlp decode");
+
+    const std::vector<std::string> nonCanonical = {"8100", "b800", "b90001", "c2"};
+    for (const std::string &hex: nonCanonical) {
+        const std::string dump = HexStringToDump(hex);
+        bool isThrow = false;
+        try {
+            RlpReader reader((const uint8_t*)dump.data(), dump.size());
+            reader.next();
+        } catch (const Exception &) {
+            isThrow = true;
+        }
+        CHECK(isThrow, "Incorrect rlp accepted " + hex);
+    }
+
+    //Подписанная транзакция разбирается на 9 полей и собирается обратно в тот же дамп
+    const std::string tx = HexStringToDump("f899018506c088e200828208948d78b1ab426dc9daa7427b7a60e64633f62e645f85746a528800b001010101010101010101010101010101010101010101010101010101010101010101010101010101010101010101010126a047dd9f6ebce749230df9ac9d57db85f948db0775882cb63565501fe95ddfcb58a07c7020426395bc781fc06e4fbb5cffc5c4d8b77d37596b1c83fa0c21ce37cfb3");
+    RlpReader txReader((const uint8_t*)tx.data(), tx.size());
+    RlpReader fields = txReader.nextList();
+    std::vector<RlpItem> items;
+    size_t payloadSize = 0;
+    while (!fields.isEnd()) {
+        items.emplace_back(fields.nextString());
+        payloadSize += RlpStringSize(items.back().data, items.back().size);
+    }
+    CHECK(txReader.isEnd() && items.size() == 9, "Incorrect transaction");
+    CHECK(DumpToHexString(items[3].data, items[3].size) == "8d78b1ab426dc9daa7427b7a60e64633f62e645f", "Incorrect to");
+    CHECK(items[6].size == 1 && items[6].data[0] == 38, "Incorrect v");
+    std::string encoded(RlpListSize(payloadSize), '\0');
+    RlpWriter writer((uint8_t*)&encoded[0], encoded.size());
+    writer.writeList(payloadSize);
+    for (const RlpItem &item: items) {
+        writer.writeString(item.data, item.size);
+    }
+    CHECK(writer.size() == encoded.size() && encoded == tx, "Incorrect rlp round trip");
+    std::cout << "Ok" << std::endl;
+}
+
 static void testBitcoinTransaction() {
     std::vector<BtcInput> is;
     BtcInput input;
@@ -207,6 +691,8 @@ void allTests() {
     testSsl("123", "Message 3");
     testSsl("Password 1", "Message 4");
     testSsl("Password 1111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111", "Message 4");
+    testSslPool("Password 1", "Message 5");
+    testSslBatch("Password 1");
 
     //testCreateMth("");
     testCreateMth("1");
@@ -227,6 +713,22 @@ void allTests() {
     testCreateBtc("Password 111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111");
 
     testEthWallet();
+    testRlp();
+    testSignTransactionsEth();
+    testSignTypedTransactionEth();
+    testErc20Payouts();
+    testSecp256k1Contexts();
+    testKdfProfiles();
+
+    testWalletsCache("Password 1");
+
+    testScryptCancel();
+    testScryptKernels();
+    testScryptBatch();
+    testSha256();
+    testKeccak();
+    testHex();
+    testBase58();
 
     testBitcoinTransaction();
     testBitcoinTransaction2();
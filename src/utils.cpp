@@ -10,12 +10,14 @@
 #include <QDir>
 
 #include "btctx/Base58.h"
+#include "ethtx/hex.h"
 
 #include "check.h"
 
 std::string toHex(const std::string &data) {
-    QByteArray array(data.data(), data.size());
-    return QString(array.toHex()).toStdString();
+    std::string result(HexEncodedSize(data.size()), '\0');
+    HexEncode((const uint8_t*)data.data(), data.size(), &result[0]);
+    return result;
 }
 
 std::string toBase64(const std::string &value) {
@@ -31,8 +33,9 @@ std::string base58ToHex(const std::string &value) {
 }
 
 std::string fromHex(const std::string &value) {
-    QByteArray pubKeyArray(value.data(), value.size());
-    return QByteArray::fromHex(pubKeyArray).toStdString();
+    std::string result(HexDecodedSize(value.size()), '\0');
+    CHECK(HexDecode(value.data(), value.size(), (uint8_t*)&result[0]), "Incorrect hex " + value);
+    return result;
 }
 
 bool isDecimal(const std::string &str) {
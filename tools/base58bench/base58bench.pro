@@ -0,0 +1,19 @@
+# Бенчмарк Base58 и пакетной проверки адресов на исходниках MetaGate, без Qt:
+#   qmake tools/base58bench/base58bench.pro && make && ./base58bench --count=100000
+
+TEMPLATE = app
+TARGET = base58bench
+
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+SRC_DIR = $$PWD/../../src
+SCRYPT_DIR = $$SRC_DIR/ethtx/scrypt
+
+INCLUDEPATH += $$SRC_DIR
+
+SOURCES += main.cpp \
+    $$SRC_DIR/btctx/Base58.cpp \
+    $$SCRYPT_DIR/cpufeatures.cpp \
+    $$SCRYPT_DIR/sha256.cpp \
+    $$SCRYPT_DIR/sha256-x86.cpp
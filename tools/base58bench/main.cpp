@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "btctx/Base58.h"
+#include "ethtx/scrypt/sha256.h"
+
+/*
+   Меряет EncodeBase58BTC и DecodeBase58 на данных разной длины и validateAddresses
+   на списке случайных адресов против проверки по одному адресу.
+   Результат - json в stdout.
+   */
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t count = 100000;
+    size_t repeat = 3;
+};
+
+static bool parseSize(const std::string &arg, const std::string &name, size_t &value) {
+    if (arg.compare(0, name.size(), name) != 0) {
+        return false;
+    }
+    value = std::stoull(arg.substr(name.size()));
+    return true;
+}
+
+static bool parseArgs(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (!parseSize(arg, "--count=", options.count) && !parseSize(arg, "--repeat=", options.repeat)) {
+            return false;
+        }
+    }
+    return options.count != 0 && options.repeat != 0;
+}
+
+// Операций в секунду, лучший из repeat замеров
+template<class Function>
+static double measure(size_t count, size_t repeat, const Function &func) {
+    double best = 0;
+    for (size_t i = 0; i < repeat; i++) {
+        const Clock::time_point begin = Clock::now();
+        func();
+        const double perSecond = count / std::chrono::duration<double>(Clock::now() - begin).count();
+        best = std::max(best, perSecond);
+    }
+    return best;
+}
+
+static std::string makeAddress(size_t index) {
+    unsigned char address[25];
+    address[0] = 0;
+    for (size_t i = 1; i < 21; i++) {
+        address[i] = (unsigned char)(index * 131 + i * 29);
+    }
+    unsigned char hash[SHA256_DIGEST_SIZE];
+    libscrypt_SHA256d(address, 21, hash);
+    memcpy(address + 21, hash, 4);
+    return EncodeBase58BTC(address, address + sizeof(address));
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            throw std::invalid_argument("unknown argument");
+        }
+    } catch (const std::exception &) {
+        std::cerr << "Usage: base58bench [--count=100000] [--repeat=3]" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream out;
+    out << "{\"codec\":[";
+    // Адрес, WIF, зашифрованный BIP38 ключ и длинные данные
+    const std::vector<size_t> sizes = {25, 38, 43, 128, 1024};
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const size_t size = sizes[s];
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = (unsigned char)(i * 167 + 13);
+        }
+        const size_t count = std::max<size_t>(options.count * 25 * 25 / (size * size), 1);
+        std::string encoded;
+        const double encodePerSecond = measure(count, options.repeat, [&]() {
+            for (size_t i = 0; i < count; i++) {
+                encoded = EncodeBase58BTC(data.data(), data.data() + data.size());
+            }
+        });
+        std::vector<unsigned char> decoded;
+        bool ok = true;
+        const double decodePerSecond = measure(count, options.repeat, [&]() {
+            for (size_t i = 0; i < count; i++) {
+                ok &= DecodeBase58(encoded.c_str(), decoded);
+            }
+        });
+        if (!ok || decoded != data) {
+            std::cerr << "Decode error at size " << size << std::endl;
+            return 1;
+        }
+        out << (s == 0 ? "" : ",") << "{\"bytes\":" << size << ",\"encode_per_second\":" << encodePerSecond << ",\"decode_per_second\":" << decodePerSecond << "}";
+    }
+    out << "]";
+
+    std::vector<std::string> addresses;
+    addresses.reserve(options.count);
+    for (size_t i = 0; i < options.count; i++) {
+        addresses.emplace_back(makeAddress(i));
+    }
+    std::vector<bool> result;
+    const double batchPerSecond = measure(addresses.size(), options.repeat, [&]() {
+        result = validateAddresses(addresses);
+    });
+    size_t valid = std::count(result.begin(), result.end(), true);
+    const double singlePerSecond = measure(addresses.size(), options.repeat, [&]() {
+        for (const std::string &address: addresses) {
+            result = validateAddresses({address});
+        }
+    });
+    if (valid != addresses.size()) {
+        std::cerr << "Invalid addresses " << addresses.size() - valid << std::endl;
+        return 1;
+    }
+    out << ",\"validate\":{\"addresses\":" << addresses.size() << ",\"batch_per_second\":" << batchPerSecond << ",\"single_per_second\":" << singlePerSecond << "}}";
+
+    std::cout << out.str() << std::endl;
+    return 0;
+}
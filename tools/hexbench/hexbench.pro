@@ -0,0 +1,16 @@
+# Бенчмарк hex кодека на исходниках MetaGate, без Qt:
+#   qmake tools/hexbench/hexbench.pro && make && ./hexbench --max-size=1048576
+
+TEMPLATE = app
+TARGET = hexbench
+
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+ETHTX_DIR = $$PWD/../../src/ethtx
+
+INCLUDEPATH += $$ETHTX_DIR
+
+SOURCES += main.cpp \
+    $$ETHTX_DIR/hex.cpp \
+    $$ETHTX_DIR/scrypt/cpufeatures.cpp
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hex.h"
+#include "scrypt/cpufeatures.h"
+
+/*
+   Меряет HexEncode и HexDecode на размерах от 32 байт до max-size, удваивая размер.
+   Для сравнения меряется прежний HexStringToDump с вставкой в начало строки, пока он укладывается в разумное время.
+   Время на байт должно оставаться постоянным для нового кодека и расти линейно для прежнего.
+   Результат - json в stdout.
+   */
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t maxSize = 1 << 20;
+    size_t maxLegacySize = 1 << 16;
+    // Примерное число байт, обрабатываемое в одном замере
+    size_t volume = 64 << 20;
+};
+
+static bool parseSize(const std::string &arg, const std::string &name, size_t &value) {
+    if (arg.compare(0, name.size(), name) != 0) {
+        return false;
+    }
+    value = std::stoull(arg.substr(name.size()));
+    return true;
+}
+
+static bool parseArgs(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (!parseSize(arg, "--max-size=", options.maxSize) &&
+            !parseSize(arg, "--max-legacy-size=", options.maxLegacySize) &&
+            !parseSize(arg, "--volume=", options.volume)
+        ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Прежняя реализация HexStringToDump без проверок символов
+static std::string legacyDecode(const std::string& hexstr) {
+    std::string decoded = "";
+    for (int cnt = (int)hexstr.size()-1; cnt >= 0;) {
+        unsigned char a = hexstr.at(cnt);
+        --cnt;
+        unsigned char b = (cnt >= 0) ? hexstr.at(cnt) : '0';
+        --cnt;
+        a = (a <= '9') ? a - '0' : (a | 0x20) - 'a' + 10;
+        b = (b <= '9') ? b - '0' : (b | 0x20) - 'a' + 10;
+        decoded.insert(decoded.begin(), (unsigned char)((b << 4) + a));
+    }
+    return decoded;
+}
+
+// Наносекунды на байт дампа, минимум из трех замеров
+template<class Function>
+static double measure(size_t size, size_t volume, const Function &func) {
+    const size_t repeat = std::max<size_t>(volume / std::max<size_t>(size, 1), 1);
+    double best = 0;
+    for (size_t attempt = 0; attempt < 3; attempt++) {
+        const Clock::time_point begin = Clock::now();
+        for (size_t i = 0; i < repeat; i++) {
+            func();
+        }
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / (double(repeat) * size);
+        if (attempt == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            throw std::invalid_argument("unknown argument");
+        }
+    } catch (const std::exception &) {
+        std::cerr << "Usage: hexbench [--max-size=1048576] [--max-legacy-size=65536] [--volume=67108864]" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> dump(options.maxSize);
+    for (size_t i = 0; i < dump.size(); i++) {
+        dump[i] = (uint8_t)(i * 167 + 13);
+    }
+    std::vector<char> hex(HexEncodedSize(options.maxSize));
+    std::vector<uint8_t> decoded(options.maxSize);
+    HexEncode(dump.data(), dump.size(), hex.data());
+
+    std::ostringstream out;
+    out << "{\"avx2\":" << ((libscrypt_cpu_features() & LIBSCRYPT_CPU_AVX2) ? "true" : "false") << ",\"sizes\":[";
+    bool first = true;
+    for (size_t size = 32; size <= options.maxSize; size *= 2) {
+        const double encodeNs = measure(size, options.volume, [&]() {
+            HexEncode(dump.data(), size, hex.data());
+        });
+        bool valid = true;
+        const double decodeNs = measure(size, options.volume, [&]() {
+            valid &= HexDecode(hex.data(), HexEncodedSize(size), decoded.data());
+        });
+        if (!valid || memcmp(decoded.data(), dump.data(), size) != 0) {
+            std::cerr << "Decode error at size " << size << std::endl;
+            return 1;
+        }
+        out << (first ? "" : ",") << "{\"bytes\":" << size << ",\"encode_ns_per_byte\":" << encodeNs << ",\"decode_ns_per_byte\":" << decodeNs;
+        if (size <= options.maxLegacySize) {
+            const std::string hexStr(hex.data(), HexEncodedSize(size));
+            const double legacyNs = measure(size, options.volume / 64, [&]() {
+                valid &= legacyDecode(hexStr).size() == size;
+            });
+            out << ",\"legacy_decode_ns_per_byte\":" << legacyNs;
+        }
+        out << "}";
+        first = false;
+    }
+    out << "]}";
+
+    std::cout << out.str() << std::endl;
+    return 0;
+}
@@ -0,0 +1,24 @@
+# Бенчмарк scrypt и PBKDF2 на исходниках MetaGate, без Qt:
+#   qmake tools/kdfbench/kdfbench.pro && make && ./kdfbench --target-ms=1000
+
+TEMPLATE = app
+TARGET = kdfbench
+
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+SCRYPT_DIR = $$PWD/../../src/ethtx/scrypt
+
+INCLUDEPATH += $$SCRYPT_DIR
+
+SOURCES += main.cpp \
+    $$SCRYPT_DIR/crypto_scrypt.cpp \
+    $$SCRYPT_DIR/crypto_scrypt_arena.cpp \
+    $$SCRYPT_DIR/crypto_scrypt-nosse.cpp \
+    $$SCRYPT_DIR/crypto_scrypt-sse.cpp \
+    $$SCRYPT_DIR/crypto_scrypt-avx2.cpp \
+    $$SCRYPT_DIR/cpufeatures.cpp \
+    $$SCRYPT_DIR/sha256.cpp \
+    $$SCRYPT_DIR/sha256-x86.cpp
+
+unix: LIBS += -lpthread
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "libscrypt.h"
+#include "sha256.h"
+
+/*
+   Меряет задержку и пропускную способность scrypt и PBKDF2-HMAC-SHA256 на текущей машине
+   и подбирает наибольшее N (r=8, p=1), укладывающееся в заданное время разблокировки.
+   Результат - json в stdout.
+   */
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    double targetMs = 1000;
+    size_t repeat = 3;
+    std::vector<size_t> threads;
+    libscrypt_kernel kernel = LIBSCRYPT_KERNEL_AUTO;
+    unsigned int maxLogN = 22;
+};
+
+struct Measure {
+    double medianMs = 0;
+    double minMs = 0;
+    double maxMs = 0;
+    // Вычислений в секунду по всем потокам
+    double perSecond = 0;
+};
+
+struct ScryptParams {
+    std::string name;
+    uint64_t N;
+    uint32_t r;
+    uint32_t p;
+};
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+    if (values.size() % 2 == 0) {
+        return (values[middle - 1] + values[middle]) / 2;
+    }
+    return values[middle];
+}
+
+/*
+   Запускает func одновременно в countThreads потоках repeat раз.
+   Задержка - время одного вызова, пропускная способность - вызовы всех потоков в секунду.
+   */
+template<class Function>
+static Measure measure(size_t countThreads, size_t repeat, const Function &func) {
+    std::vector<std::vector<double>> times(countThreads);
+    const Clock::time_point begin = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < countThreads; t++) {
+        threads.emplace_back([&func, &times, t, repeat]() {
+            for (size_t i = 0; i < repeat; i++) {
+                const Clock::time_point callBegin = Clock::now();
+                func(t);
+                times[t].push_back(std::chrono::duration<double, std::milli>(Clock::now() - callBegin).count());
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    const double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    std::vector<double> all;
+    for (const std::vector<double> &t: times) {
+        all.insert(all.end(), t.begin(), t.end());
+    }
+    Measure result;
+    result.medianMs = median(all);
+    result.minMs = *std::min_element(all.begin(), all.end());
+    result.maxMs = *std::max_element(all.begin(), all.end());
+    result.perSecond = all.size() * 1000. / totalMs;
+    return result;
+}
+
+static void runScrypt(const ScryptParams &params, size_t salt) {
+    const std::string password = "kdfbench password";
+    const std::string saltStr = "kdfbench salt " + std::to_string(salt);
+    uint8_t derivedKey[32];
+    if (libscrypt_scrypt((const uint8_t*)password.data(), password.size(), (const uint8_t*)saltStr.data(), saltStr.size(), params.N, params.r, params.p, derivedKey, sizeof(derivedKey)) != 0) {
+        std::cerr << "scrypt error " << params.name << std::endl;
+        std::exit(1);
+    }
+}
+
+static std::string toJson(const Measure &m) {
+    std::ostringstream out;
+    out << "{\"median_ms\":" << m.medianMs << ",\"min_ms\":" << m.minMs << ",\"max_ms\":" << m.maxMs << ",\"per_second\":" << m.perSecond << "}";
+    return out.str();
+}
+
+static const char* kernelName(libscrypt_kernel kernel) {
+    switch (kernel) {
+    case LIBSCRYPT_KERNEL_NOSSE:
+        return "nosse";
+    case LIBSCRYPT_KERNEL_SSE2:
+        return "sse2";
+    case LIBSCRYPT_KERNEL_AVX2:
+        return "avx2";
+    default:
+        return "auto";
+    }
+}
+
+static bool parseArgs(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const size_t eq = arg.find('=');
+        const std::string name = arg.substr(0, eq);
+        const std::string value = eq == arg.npos ? "" : arg.substr(eq + 1);
+        if (name == "--target-ms") {
+            options.targetMs = std::stod(value);
+        } else if (name == "--repeat") {
+            options.repeat = std::max(std::stoul(value), 1ul);
+        } else if (name == "--max-log-n") {
+            options.maxLogN = std::stoul(value);
+        } else if (name == "--threads") {
+            std::istringstream stream(value);
+            std::string item;
+            while (std::getline(stream, item, ',')) {
+                options.threads.push_back(std::max(std::stoul(item), 1ul));
+            }
+        } else if (name == "--kernel") {
+            if (value == "nosse") {
+                options.kernel = LIBSCRYPT_KERNEL_NOSSE;
+            } else if (value == "sse2") {
+                options.kernel = LIBSCRYPT_KERNEL_SSE2;
+            } else if (value == "avx2") {
+                options.kernel = LIBSCRYPT_KERNEL_AVX2;
+            } else if (value != "auto") {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            throw std::invalid_argument("unknown argument");
+        }
+    } catch (const std::exception &) {
+        std::cerr << "Usage: kdfbench [--target-ms=1000] [--repeat=3] [--threads=1,2,4] [--kernel=auto|nosse|sse2|avx2] [--max-log-n=22]" << std::endl;
+        return 1;
+    }
+    const size_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (options.threads.empty()) {
+        for (size_t t = 1; t < hardwareThreads; t *= 2) {
+            options.threads.push_back(t);
+        }
+        options.threads.push_back(hardwareThreads);
+    }
+    if (libscrypt_set_kernel(options.kernel) != 0) {
+        std::cerr << "Kernel " << kernelName(options.kernel) << " not supported" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream out;
+    out << "{\"hardware_threads\":" << hardwareThreads << ",\"kernel\":\"" << kernelName(libscrypt_get_kernel()) << "\",\"target_ms\":" << options.targetMs;
+
+    // PBKDF2-HMAC-SHA256: одна итерация на блок, как в scrypt, и 100000 итераций
+    out << ",\"pbkdf2\":[";
+    const std::vector<std::pair<uint64_t, size_t>> pbkdf2Params = {{1, 1024}, {1, 128 * 8 * 8}, {100000, 32}};
+    for (size_t i = 0; i < pbkdf2Params.size(); i++) {
+        const uint64_t iterations = pbkdf2Params[i].first;
+        const size_t length = pbkdf2Params[i].second;
+        const Measure m = measure(1, options.repeat, [iterations, length](size_t) {
+            std::vector<uint8_t> result(length);
+            libscrypt_PBKDF2_SHA256((const uint8_t*)"password", 8, (const uint8_t*)"salt", 4, iterations, result.data(), result.size());
+        });
+        out << (i == 0 ? "" : ",") << "{\"iterations\":" << iterations << ",\"dk_len\":" << length << ",\"latency\":" << toJson(m) << "}";
+    }
+    out << "]";
+
+    // Параметры, которые используются в MetaGate
+    out << ",\"scrypt\":[";
+    const std::vector<ScryptParams> scryptParams = {
+        {"eth_keystore", 262144, 8, 1},
+        {"bip38", 16384, 8, 8},
+    };
+    for (size_t i = 0; i < scryptParams.size(); i++) {
+        const ScryptParams &params = scryptParams[i];
+        out << (i == 0 ? "" : ",") << "{\"name\":\"" << params.name << "\",\"N\":" << params.N << ",\"r\":" << params.r << ",\"p\":" << params.p << ",\"threads\":[";
+        for (size_t t = 0; t < options.threads.size(); t++) {
+            const Measure m = measure(options.threads[t], options.repeat, [&params](size_t thread) {
+                runScrypt(params, thread);
+            });
+            out << (t == 0 ? "" : ",") << "{\"threads\":" << options.threads[t] << ",\"latency\":" << toJson(m) << "}";
+        }
+        out << "]}";
+    }
+    out << "]";
+
+    // Регионы арены, оставшиеся от прогонов выше, не должны ни занимать память, ни ускорять калибровку
+    libscrypt_arena_release_all();
+
+    // Калибровка: N растет, пока время одной разблокировки в одном потоке укладывается в target
+    out << ",\"calibration\":[";
+    uint64_t recommendedN = 0;
+    for (unsigned int logN = 10; logN <= options.maxLogN; logN++) {
+        const ScryptParams params{"calibration", uint64_t(1) << logN, 8, 1};
+        const Measure m = measure(1, options.repeat, [&params](size_t thread) {
+            runScrypt(params, thread);
+        });
+        out << (logN == 10 ? "" : ",") << "{\"N\":" << params.N << ",\"latency\":" << toJson(m) << "}";
+        if (m.medianMs > options.targetMs) {
+            break;
+        }
+        recommendedN = params.N;
+    }
+    out << "]";
+    out << ",\"recommended\":{\"N\":" << recommendedN << ",\"r\":8,\"p\":1}}";
+
+    libscrypt_arena_release_all();
+    std::cout << out.str() << std::endl;
+    return 0;
+}